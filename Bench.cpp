@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include "sources/MagicalContainer.hpp"
+#include "sources/PrimeSieve.hpp"
+#include "sources/BatchPrimality.hpp"
+
+/*                           Bench.cpp
+   ======================================================================
+   Timing the sorted indexes that can back the container against each
+   other (make bench builds it with optimizations).
+   Every mix runs on BasicMagicalContainer<int> with the OrderStatisticTree
+   and with the PackedMemoryArray:
+   - insert heavy: adding random elements one by one, one scan at the end.
+   - scan heavy:   full AscendingIterator scans of a big container, with
+                   a few additions between the scans.
+   - live scan:    one AscendingIterator walks the container while an
+                   element is added every 64 steps.
+   The sort section times std::sort against radixSort on batches of
+   random ints of growing size, and prints the first size where the
+   radix sort wins (radix::threshold in RadixSort.hpp should be close).
+   The universe section compares the OrderStatisticTree with the
+   BoundedUniverseIndex of a 24 bit universe, on a dense universe (the
+   elements cover most of [0, 2^18)) and on a sparse one (the same number
+   of elements spread over [0, 2^24)): adding the elements one by one,
+   scanning them with the AscendingIterator (a successor query per step
+   for the universe index) and removing them one by one.
+   The primes section classifies batches of random ints just below 2^31
+   with isPrime() one by one and with a PrimeSieve over the range of the
+   batch, for ranges of 1 to 4096 numbers per element (the density of
+   the batch), and prints the widest range where the sieve still wins
+   (PrimeSieve::max_gap should be close). The same comparison with
+   smaller batches shows from what size the sieve pays for its base
+   primes (PrimeSieve::min_batch). The last table times isPrime() one
+   by one against isPrimeBatch() (8 at a time with AVX2) on random ints
+   below 2^31, by batch size (primality::batch_threshold should be
+   close to where the batch starts to win).
+   ======================================================================
+*/
+
+using namespace ariel;
+
+using TreeContainer = BasicMagicalContainer<int>;
+using PackedContainer = BasicMagicalContainer<int, std::less<int>, 16, DoublingGrowth, PackedMemoryArray>;
+using UniverseContainer = BasicMagicalContainer<int, std::less<int>, 16, DoublingGrowth, BoundedUniverse<24>::Index>;
+
+static const int elements = 200000;
+
+static std::vector<int> randomValues(std::size_t count, unsigned seed, int low = 0, int high = 100000000) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(low, high);
+    std::vector<int> values(count);
+    for (int& value : values) {
+        value = distribution(generator);
+    }
+    return values;
+}
+
+template <typename Function>
+static double milliseconds(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the sum of the elements, so the scans are not optimized away
+static std::int64_t checksum = 0;
+
+template <typename Container>
+static void scan(Container& container) {
+    typename Container::AscendingIterator iterator(container);
+    for (auto it = iterator.begin(); it != iterator.end(); ++it) {
+        checksum += *it;
+    }
+}
+
+template <typename Container>
+static double insertHeavy() {
+    std::vector<int> values = randomValues(elements, 1);
+    return milliseconds([&] {
+        Container container;
+        for (int value : values) {
+            container.addElement(value);
+        }
+        scan(container);
+    });
+}
+
+template <typename Container>
+static double scanHeavy() {
+    std::vector<int> values = randomValues(elements, 2);
+    std::vector<int> extra = randomValues(500, 3);
+    Container container;
+    container.addElements(values.begin(), values.end());
+    return milliseconds([&] {
+        for (std::size_t round = 0; round < 50; ++round) {
+            scan(container);
+            for (std::size_t i = 0; i < 10; ++i) {
+                container.addElement(extra[10 * round + i]);
+            }
+        }
+    });
+}
+
+template <typename Container>
+static double liveScan() {
+    std::vector<int> values = randomValues(elements, 4);
+    std::vector<int> extra = randomValues(elements / 64 + 1, 5);
+    Container container;
+    container.addElements(values.begin(), values.end());
+    return milliseconds([&] {
+        typename Container::AscendingIterator iterator(container);
+        std::size_t steps = 0;
+        for (auto it = iterator.begin(); it != iterator.end(); ++it) {
+            checksum += *it;
+            if (++steps % 64 == 0) {
+                container.addElement(extra[steps / 64]);
+            }
+        }
+    });
+}
+
+static void report(const std::string& mix, double tree, double packed) {
+    std::cout << std::left << std::setw(14) << mix << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << tree << std::setw(12) << packed << std::endl;
+}
+
+// the time to sort size elements, repeated so every size sorts about 4M elements
+template <typename Sort>
+static double sortTime(std::size_t size, Sort sort) {
+    std::size_t rounds = std::max<std::size_t>(1, (std::size_t{1} << 22U) / size);
+    std::vector<int> values = randomValues(size * rounds, 6, -1000000000, 1000000000);
+    return milliseconds([&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            sort(std::span<int>(values.data() + round * size, size));
+        }
+    });
+}
+
+static void sortSection() {
+    std::cout << std::endl << "sorting 4M ints in batches of size, milliseconds" << std::endl;
+    std::cout << std::left << std::setw(14) << "size" << std::right << std::setw(12) << "std::sort" << std::setw(12) << "radix" << std::endl;
+    std::size_t crossover = 0;
+    for (std::size_t size = 16; size <= (std::size_t{1} << 22U); size *= 2) {
+        double comparison = sortTime(size, [](std::span<int> batch) { std::sort(batch.begin(), batch.end()); });
+        double radix = sortTime(size, [](std::span<int> batch) { radixSort(batch); });
+        report(std::to_string(size), comparison, radix);
+        if (crossover == 0 && radix < comparison) {
+            crossover = size;
+        }
+    }
+    std::cout << "radix sort wins from " << crossover << " elements" << std::endl;
+}
+
+struct UniverseTimes {
+    double insert;
+    double scan;
+    double remove;
+};
+
+template <typename Container>
+static UniverseTimes universeTimes(const std::vector<int>& values) {
+    UniverseTimes times{};
+    Container container;
+    times.insert = milliseconds([&] {
+        for (int value : values) {
+            container.addElement(value);
+        }
+    });
+    times.scan = milliseconds([&] {
+        for (int round = 0; round < 10; ++round) {
+            scan(container);
+        }
+    });
+    times.remove = milliseconds([&] {
+        for (int value : values) {
+            container.removeElement(value);
+        }
+    });
+    return times;
+}
+
+static void universeSection() {
+    std::cout << std::endl << elements << " elements in a 24 bit universe, milliseconds (10 scans)" << std::endl;
+    std::cout << std::left << std::setw(14) << "mix" << std::right << std::setw(12) << "tree" << std::setw(12) << "universe" << std::endl;
+    for (bool dense : {true, false}) {
+        std::vector<int> values = randomValues(elements, 7, 0, dense ? (1 << 18) - 1 : (1 << 24) - 1);
+        UniverseTimes tree = universeTimes<TreeContainer>(values);
+        UniverseTimes universe = universeTimes<UniverseContainer>(values);
+        std::string name = dense ? "dense " : "sparse ";
+        report(name + "insert", tree.insert, universe.insert);
+        report(name + "scan", tree.scan, universe.scan);
+        report(name + "remove", tree.remove, universe.remove);
+    }
+}
+
+// the time to classify values one by one and with a sieve, repeated so every batch size classifies about 4M elements
+static std::pair<double, double> classifyTimes(std::size_t count, std::uint64_t gap) {
+    std::size_t rounds = std::max<std::size_t>(1, (std::size_t{1} << 22U) / count);
+    int high = 2147483646;
+    int low = high - static_cast<int>(std::min<std::uint64_t>(count * gap, 1U << 30U));
+    std::vector<int> values = randomValues(count, 8, low, high);
+    auto [smallest, largest] = std::minmax_element(values.begin(), values.end());
+    double testing = milliseconds([&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (int value : values) {
+                checksum += isPrime(value) ? 1 : 0;
+            }
+        }
+    });
+    double sieving = milliseconds([&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            PrimeSieve<int> sieve(*smallest, *largest);
+            for (int value : values) {
+                checksum += sieve.contains(value) ? 1 : 0;
+            }
+        }
+    });
+    return {testing, sieving};
+}
+
+static void primesSection() {
+    std::cout << std::endl << "classifying 4M ints below 2^31 in batches of " << elements << ", milliseconds" << std::endl;
+    std::cout << std::left << std::setw(14) << "range/element" << std::right << std::setw(12) << "isPrime" << std::setw(12) << "sieve" << std::endl;
+    std::uint64_t widest = 0;
+    for (std::uint64_t gap = 1; gap <= 4096; gap *= 2) {
+        auto [testing, sieving] = classifyTimes(elements, gap);
+        report(std::to_string(gap), testing, sieving);
+        if (sieving < testing) {
+            widest = gap;
+        }
+    }
+    std::cout << "the sieve wins up to " << widest << " numbers per element" << std::endl;
+    std::cout << std::left << std::setw(14) << "batch (gap 16)" << std::right << std::setw(12) << "isPrime" << std::setw(12) << "sieve" << std::endl;
+    std::size_t smallest = 0;
+    for (std::size_t count = 64; count <= 65536; count *= 4) {
+        auto [testing, sieving] = classifyTimes(count, 16);
+        report(std::to_string(count), testing, sieving);
+        if (smallest == 0 && sieving < testing) {
+            smallest = count;
+        }
+    }
+    std::cout << "the sieve wins from batches of " << smallest << std::endl;
+
+    std::cout << std::left << std::setw(14) << "batch" << std::right << std::setw(12) << "isPrime" << std::setw(13) << "isPrimeBatch"
+              << (isPrimeBatchVectorized<int>() ? " (AVX2)" : " (scalar)") << std::endl;
+    std::size_t batchWins = 0;
+    for (std::size_t count = 8; count <= 65536; count *= 4) {
+        std::size_t rounds = (std::size_t{1} << 22U) / count;
+        std::vector<int> values = randomValues(count * rounds, 9, 0, 2147483646);
+        std::vector<std::uint8_t> flags(count);
+        double testing = milliseconds([&] {
+            for (int value : values) {
+                checksum += isPrime(value) ? 1 : 0;
+            }
+        });
+        double batched = milliseconds([&] {
+            for (std::size_t round = 0; round < rounds; ++round) {
+                isPrimeBatch(std::span<const int>(values.data() + round * count, count), std::span<std::uint8_t>(flags));
+                checksum += flags[0];
+            }
+        });
+        report(std::to_string(count), testing, batched);
+        if (batchWins == 0 && batched < testing) {
+            batchWins = count;
+        }
+    }
+    std::cout << "isPrimeBatch wins from batches of " << batchWins << std::endl;
+}
+
+int main() {
+    std::cout << elements << " elements, milliseconds" << std::endl;
+    std::cout << std::left << std::setw(14) << "mix" << std::right << std::setw(12) << "tree" << std::setw(12) << "packed" << std::endl;
+    report("insert heavy", insertHeavy<TreeContainer>(), insertHeavy<PackedContainer>());
+    report("scan heavy", scanHeavy<TreeContainer>(), scanHeavy<PackedContainer>());
+    report("live scan", liveScan<TreeContainer>(), liveScan<PackedContainer>());
+    sortSection();
+    universeSection();
+    primesSection();
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
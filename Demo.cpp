@@ -38,6 +38,25 @@ int main() {
     }
     std::cout << std::endl;
 
+    // Use DescendingIterator to display elements from the largest
+    std::cout << "Elements in descending order:\n";
+    MagicalContainer::DescendingIterator descIter(container);
+    for (auto it = descIter.begin(); it != descIter.end(); ++it) {
+        std::cout << *it << ' ';  // 25 17 9 3 2
+    }
+    std::cout << std::endl;
+
+    // Use MergedAscendingIterator to display two containers as one
+    std::cout << "Elements of two containers in ascending order:\n";
+    MagicalContainer other;
+    other.addElement(4);
+    other.addElement(20);
+    MagicalContainer::MergedAscendingIterator mergedIter({&container, &other});
+    for (auto it = mergedIter.begin(); it != mergedIter.end(); ++it) {
+        std::cout << *it << ' ';  // 2 3 4 9 17 20 25
+    }
+    std::cout << std::endl;
+
     // Remove an element from the container and display the size
     container.removeElement(9);
     std::cout << "Size of container after removing an element: " << container.size() << std::endl;
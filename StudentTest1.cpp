@@ -1,9 +1,56 @@
 #include "doctest.h"
 #include "sources/MagicalContainer.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <list>
+#include <span>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
 
 using namespace ariel;
 using namespace std;
+
+// counting the heap allocations of the whole test program
+static size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* memory = malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// std::pmr::new_delete_resource() allocates with the aligned forms
+void* operator new(size_t size, align_val_t alignment) {
+    ++allocation_count;
+    size_t align = static_cast<size_t>(alignment);
+    if (void* memory = aligned_alloc(align, (size + align - 1) / align * align)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* memory, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, align_val_t) noexcept {
+    free(memory);
+}
 // Test case for adding elements to the MagicalContainer
 TEST_CASE("Adding elements to MagicalContainer") {
     MagicalContainer container;
@@ -597,3 +644,1680 @@ TEST_CASE("operator= throws when iterators are pointing at different containers"
 }
 
 
+
+// Test case for iterators that stay attached while the container changes
+TEST_CASE("Iterators see elements added and removed after they were created") {
+    MagicalContainer container;
+    container.addElement(10);
+    container.addElement(30);
+    container.addElement(7);
+
+    SUBCASE("AscendingIterator") {
+        MagicalContainer::AscendingIterator it(container);
+        CHECK(*it == 7);
+        ++it;
+        CHECK(*it == 10);
+        container.addElement(20);
+        ++it;
+        CHECK(*it == 20);
+        container.removeElement(30);
+        ++it;
+        CHECK(it == it.end());
+    }
+
+    SUBCASE("SideCrossIterator") {
+        MagicalContainer::SideCrossIterator it(container);
+        CHECK(*it == 7);
+        ++it;
+        CHECK(*it == 30);
+        container.addElement(20);
+        ++it;
+        CHECK(*it == 10);
+        ++it;
+        CHECK(*it == 20);
+        ++it;
+        CHECK(it == it.end());
+    }
+
+    SUBCASE("PrimeIterator") {
+        MagicalContainer::PrimeIterator it(container);
+        CHECK(*it == 7);
+        container.addElement(13);
+        container.addElement(2);
+        CHECK(*it == 2);
+        ++it;
+        CHECK(*it == 7);
+        ++it;
+        CHECK(*it == 13);
+        ++it;
+        CHECK(it == it.end());
+    }
+}
+
+// Test case for the comparison operators that compare locations and not elements
+TEST_CASE("SideCrossIterator compares locations") {
+    MagicalContainer container;
+    container.addElement(1);
+    container.addElement(2);
+    container.addElement(4);
+    container.addElement(5);
+    container.addElement(14);
+
+    MagicalContainer::SideCrossIterator it14(container);
+    ++it14;
+    MagicalContainer::SideCrossIterator it5(container);
+    ++(++(++it5));
+    CHECK(*it14 == 14);
+    CHECK(*it5 == 5);
+    CHECK(it5 > it14);
+    CHECK(it14 < it5);
+    CHECK(it5.end() > it5);
+}
+
+// Test case for a long sequence of additions and removals
+TEST_CASE("Many additions and removals keep the orders right") {
+    MagicalContainer container;
+    vector<int> expected;
+    unsigned int seed = 12345;
+    for (int i = 0; i < 2000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int value = static_cast<int>((seed >> 16) % 500) - 100;
+        if (i % 3 == 2 && !expected.empty()) {
+            value = expected[(seed >> 8) % expected.size()];
+            container.removeElement(value);
+            expected.erase(find(expected.begin(), expected.end(), value));
+        } else {
+            container.addElement(value);
+            expected.push_back(value);
+        }
+    }
+    sort(expected.begin(), expected.end());
+    CHECK(container.size() == static_cast<int>(expected.size()));
+
+    vector<int> ascending;
+    MagicalContainer::AscendingIterator asc(container);
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        ascending.push_back(*it);
+    }
+    CHECK(ascending == expected);
+
+    vector<int> cross;
+    MagicalContainer::SideCrossIterator side(container);
+    for (auto it = side.begin(); it != side.end(); ++it) {
+        cross.push_back(*it);
+    }
+    vector<int> expectedCross;
+    for (size_t front = 0, back = expected.size(); front < back;) {
+        expectedCross.push_back(expected[front++]);
+        if (front < back) {
+            expectedCross.push_back(expected[--back]);
+        }
+    }
+    CHECK(cross == expectedCross);
+}
+
+// Test case for the tombstones that removeElement leaves behind
+TEST_CASE("Removed elements are compacted away at the threshold") {
+    for (double threshold : {0.0, 0.25, 1.0}) {
+        MagicalContainer container;
+        container.setCompactionThreshold(threshold);
+        vector<int> expected;
+        for (int i = 0; i < 300; ++i) {
+            container.addElement(i);
+            expected.push_back(i);
+        }
+        MagicalContainer::AscendingIterator asc(container);
+        ++(++(++asc));
+        MagicalContainer::PrimeIterator prime(container);
+        // removing everything but the multiples of 3 from the back
+        for (int i = 299; i >= 0; --i) {
+            if (i % 3 != 0) {
+                container.removeElement(i);
+                expected.erase(find(expected.begin(), expected.end(), i));
+            }
+        }
+        CHECK(container.size() == 100);
+        CHECK(*asc == 9);
+        CHECK(*prime == 3);
+        CHECK_THROWS_AS(container.removeElement(299), runtime_error);
+
+        vector<int> ascending;
+        for (auto it = asc.begin(); it != asc.end(); ++it) {
+            ascending.push_back(*it);
+        }
+        CHECK(ascending == expected);
+        // the removed elements come back in their places
+        container.addElement(2);
+        container.addElement(5);
+        CHECK(*asc == 5);
+        ++asc;
+        CHECK(*asc == 6);
+
+        // tightening the threshold compacts right away, nothing moves
+        container.setCompactionThreshold(0.0);
+        CHECK(*asc == 6);
+        CHECK(container.size() == 102);
+    }
+
+    MagicalContainer container;
+    CHECK_THROWS_AS(container.setCompactionThreshold(-0.5), invalid_argument);
+    CHECK_THROWS_AS(container.setCompactionThreshold(1.5), invalid_argument);
+
+    OrderStatisticTree<int> tree;
+    tree.setCompactionThreshold(0.5);
+    for (int i = 0; i < 10; ++i) {
+        tree.insert(i);
+    }
+    for (int i = 0; i < 5; ++i) {
+        CHECK(tree.erase(i));
+    }
+    CHECK(tree.tombstones() == 5);
+    CHECK(tree.size() == 5);
+    CHECK(tree.value(tree.select(0)) == 5);
+    CHECK(tree.lowerBound(7) == 2);
+    CHECK(tree.erase(5));
+    CHECK(tree.tombstones() == 0);
+    CHECK(tree.value(tree.front()) == 6);
+    CHECK(tree.size() == 4);
+}
+
+// Test case for removing duplicates and elements that were never there
+TEST_CASE("Removing duplicates and missing elements") {
+    MagicalContainer container;
+    for (int i = 0; i < 100; ++i) {
+        container.addElement(i * 1024);
+    }
+    container.addElement(7);
+    container.addElement(7);
+    container.addElement(7);
+
+    CHECK_THROWS_AS(container.removeElement(1), runtime_error);
+    CHECK_THROWS_AS(container.removeElement(-1024), runtime_error);
+    CHECK(container.size() == 103);
+
+    CHECK_NOTHROW(container.removeElement(7));
+    CHECK_NOTHROW(container.removeElement(7));
+    CHECK_NOTHROW(container.removeElement(7));
+    CHECK_THROWS_AS(container.removeElement(7), runtime_error);
+
+    for (int i = 0; i < 100; i += 2) {
+        CHECK_NOTHROW(container.removeElement(i * 1024));
+    }
+    for (int i = 0; i < 100; i += 2) {
+        CHECK_THROWS_AS(container.removeElement(i * 1024), runtime_error);
+    }
+    for (int i = 1; i < 100; i += 2) {
+        CHECK_NOTHROW(container.removeElement(i * 1024));
+    }
+    CHECK(container.size() == 0);
+}
+
+// Test case for adding a batch of elements
+TEST_CASE("Adding a batch is the same as adding one by one") {
+    vector<int> values;
+    unsigned int seed = 777;
+    for (int i = 0; i < 3000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        values.push_back(static_cast<int>((seed >> 16) % 1000) - 300);
+    }
+
+    MagicalContainer oneByOne;
+    MagicalContainer batched;
+    for (size_t i = 0; i < 100; ++i) {
+        oneByOne.addElement(values[i]);
+        batched.addElement(values[i]);
+    }
+    MagicalContainer::AscendingIterator live(batched);
+    ++(++live);
+
+    for (size_t i = 100; i < values.size(); ++i) {
+        oneByOne.addElement(values[i]);
+    }
+    SUBCASE("From a span") {
+        batched.addElements(span<const int>(values).subspan(100));
+    }
+    SUBCASE("From an iterator range") {
+        list<int> rest(values.begin() + 100, values.end());
+        batched.addElements(rest.begin(), rest.end());
+    }
+    SUBCASE("In small batches") {
+        for (size_t i = 100; i < values.size(); i += 7) {
+            size_t last = min(values.size(), i + 7);
+            batched.addElements(values.begin() + static_cast<ptrdiff_t>(i), values.begin() + static_cast<ptrdiff_t>(last));
+        }
+    }
+
+    CHECK(batched.size() == oneByOne.size());
+    MagicalContainer::AscendingIterator expectedAsc(oneByOne);
+    MagicalContainer::AscendingIterator asc(batched);
+    for (; expectedAsc != expectedAsc.end(); ++expectedAsc, ++asc) {
+        CHECK(*asc == *expectedAsc);
+    }
+    CHECK(asc == asc.end());
+
+    MagicalContainer::PrimeIterator expectedPrime(oneByOne);
+    MagicalContainer::PrimeIterator prime(batched);
+    for (; expectedPrime != expectedPrime.end(); ++expectedPrime, ++prime) {
+        CHECK(*prime == *expectedPrime);
+    }
+    CHECK(prime == prime.end());
+
+    MagicalContainer::SideCrossIterator expectedCross(oneByOne);
+    MagicalContainer::SideCrossIterator cross(batched);
+    for (; expectedCross != expectedCross.end(); ++expectedCross, ++cross) {
+        CHECK(*cross == *expectedCross);
+    }
+
+    // the iterator created before the batch still points at the third smallest
+    MagicalContainer::AscendingIterator third(oneByOne);
+    ++(++third);
+    CHECK(*live == *third);
+    CHECK_NOTHROW(batched.removeElement(values[2000]));
+}
+
+// Test case for removing a batch of elements
+TEST_CASE("Removing a batch of elements") {
+    MagicalContainer container;
+    vector<int> values;
+    for (int i = 0; i < 200; ++i) {
+        values.push_back(i % 50);
+    }
+    container.addElements(values);
+
+    MagicalContainer::AscendingIterator it(container);
+    MagicalContainer::PrimeIterator prime(container);
+
+    SUBCASE("Lenient") {
+        vector<int> toRemove = {3, 3, 3, 3, 3, 4, 1000, -1};
+        CHECK(container.removeElements(toRemove) == 5);
+        CHECK(container.size() == 195);
+        CHECK_THROWS_AS(container.removeElement(3), runtime_error);
+        CHECK_NOTHROW(container.removeElement(4));
+        CHECK(*prime == 2);
+        ++(++(++(++prime)));
+        CHECK(*prime == 5);
+    }
+
+    SUBCASE("Strict") {
+        vector<int> toRemove = {3, 3, 3, 3, 3};
+        CHECK_THROWS_AS(container.removeElements(toRemove, true), runtime_error);
+        CHECK(container.size() == 200);
+        toRemove.pop_back();
+        CHECK(container.removeElements(toRemove, true) == 4);
+        CHECK(container.size() == 196);
+    }
+
+    SUBCASE("Most of the container") {
+        vector<int> toRemove;
+        for (int i = 0; i < 200; ++i) {
+            if (i % 50 != 0) {
+                toRemove.push_back(i % 50);
+            }
+        }
+        CHECK(container.removeElements(toRemove, true) == 196);
+        CHECK(container.size() == 4);
+        CHECK(*it == 0);
+        ++(++(++it));
+        CHECK(*it == 0);
+        ++it;
+        CHECK(it == it.end());
+        CHECK(prime == prime.end());
+    }
+
+    SUBCASE("By predicate") {
+        CHECK(container.removeIf([](int element) { return element % 2 == 1; }) == 100);
+        CHECK(container.size() == 100);
+        CHECK(*prime == 2);
+        ++(++(++(++prime)));
+        CHECK(prime == prime.end());
+        CHECK_THROWS_AS(container.removeElement(7), runtime_error);
+        MagicalContainer::SideCrossIterator cross(container);
+        CHECK(*cross == 0);
+        ++cross;
+        CHECK(*cross == 48);
+        CHECK(container.removeIf([](int) { return false; }) == 0);
+    }
+}
+
+// Test case for containers of other element types
+TEST_CASE("BasicMagicalContainer with other element types") {
+    SUBCASE("int64_t") {
+        BasicMagicalContainer<int64_t> container;
+        container.addElement(5000000000LL);
+        container.addElement(-5000000000LL);
+        container.addElement(4294967311LL);
+        container.addElement(7);
+        BasicMagicalContainer<int64_t>::AscendingIterator it(container);
+        CHECK(*it == -5000000000LL);
+        ++it;
+        CHECK(*it == 7);
+        BasicMagicalContainer<int64_t>::PrimeIterator prime(container);
+        CHECK(*prime == 7);
+        ++prime;
+        CHECK(*prime == 4294967311LL);
+        ++prime;
+        CHECK(prime == prime.end());
+    }
+
+    SUBCASE("uint32_t") {
+        BasicMagicalContainer<uint32_t> container;
+        container.addElement(4294967291U);
+        container.addElement(4294967295U);
+        container.addElement(2U);
+        BasicMagicalContainer<uint32_t>::SideCrossIterator cross(container);
+        CHECK(*cross == 2U);
+        ++cross;
+        CHECK(*cross == 4294967295U);
+        BasicMagicalContainer<uint32_t>::PrimeIterator prime(container);
+        CHECK(*prime == 2U);
+        ++prime;
+        CHECK(*prime == 4294967291U);
+    }
+
+    SUBCASE("Descending order") {
+        BasicMagicalContainer<int, greater<int>> container;
+        container.addElement(1);
+        container.addElement(3);
+        container.addElement(2);
+        BasicMagicalContainer<int, greater<int>>::AscendingIterator it(container);
+        CHECK(*it == 3);
+        ++it;
+        CHECK(*it == 2);
+        BasicMagicalContainer<int, greater<int>>::PrimeIterator prime(container);
+        CHECK(*prime == 3);
+    }
+
+    SUBCASE("No PrimeIterator for elements that are not integers") {
+        BasicMagicalContainer<double> container;
+        container.addElement(2.5);
+        container.addElement(-1.0);
+        container.removeElement(2.5);
+        CHECK(container.size() == 1);
+        CHECK(is_constructible_v<BasicMagicalContainer<double>::AscendingIterator, BasicMagicalContainer<double>&>);
+        CHECK_FALSE(is_constructible_v<BasicMagicalContainer<double>::PrimeIterator, BasicMagicalContainer<double>&>);
+        CHECK(is_constructible_v<MagicalContainer::PrimeIterator, MagicalContainer&>);
+    }
+}
+
+// Test case for the primality test of every integer width
+TEST_CASE("isPrime for every width") {
+    auto naive = [](uint64_t value) {
+        if (value < 2) {
+            return false;
+        }
+        for (uint64_t divisor = 2; divisor * divisor <= value; ++divisor) {
+            if (value % divisor == 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool allMatch = true;
+    for (unsigned value = 0; value < 256; ++value) {
+        allMatch = allMatch && isPrime(static_cast<uint8_t>(value)) == naive(value);
+    }
+    for (unsigned value = 0; value < 65536; ++value) {
+        allMatch = allMatch && isPrime(static_cast<uint16_t>(value)) == naive(value);
+    }
+    for (uint32_t value = 4294967295U - 3000; value != 0; ++value) {
+        allMatch = allMatch && isPrime(value) == naive(value);
+    }
+    for (uint64_t value = 4294967296ULL; value < 4294967296ULL + 3000; ++value) {
+        allMatch = allMatch && isPrime(value) == naive(value);
+    }
+    CHECK(allMatch);
+    CHECK_FALSE(isPrime(static_cast<int8_t>(-7)));
+    CHECK_FALSE(isPrime(-2147483647));
+    CHECK(isPrime(2147483647));
+    CHECK(isPrime(static_cast<int64_t>(4294967311LL)));
+    CHECK_FALSE(isPrime(static_cast<uint64_t>(4294967311ULL * 3)));
+    static_assert(isPrime(97) && !isPrime(91));
+}
+
+TEST_CASE("Miller-Rabin primality near 2^31 and 2^63") {
+    auto naive = [](uint64_t value) {
+        if (value < 2) {
+            return false;
+        }
+        for (uint64_t divisor = 2; divisor * divisor <= value; ++divisor) {
+            if (value % divisor == 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool allMatch = true;
+    for (int64_t value = 2147483647LL - 2000; value <= 2147483647LL; ++value) {
+        allMatch = allMatch && isPrime(static_cast<int>(value)) == naive(static_cast<uint64_t>(value));
+    }
+    CHECK(allMatch);
+    CHECK(isPrime(2147483647));
+    CHECK(isPrime(4294967291U));
+    CHECK(isPrime(static_cast<uint64_t>(2305843009213693951ULL)));
+    CHECK(isPrime(static_cast<uint64_t>(18446744073709551557ULL)));
+    CHECK(isPrime(static_cast<int64_t>(9223372036854775783LL)));
+    // strong pseudoprimes to small bases, and a square of a prime
+    CHECK_FALSE(isPrime(2047));
+    CHECK_FALSE(isPrime(3215031751U));
+    CHECK_FALSE(isPrime(static_cast<uint64_t>(4759123141ULL)));
+    CHECK_FALSE(isPrime(static_cast<uint64_t>(3825123056546413051ULL)));
+    CHECK_FALSE(isPrime(static_cast<uint64_t>(4294967291ULL * 4294967291ULL)));
+    CHECK_FALSE(isPrime(static_cast<uint64_t>(18446744073709551557ULL - 2)));
+    CHECK_FALSE(isPrime(0));
+    CHECK_FALSE(isPrime(1));
+    CHECK_FALSE(isPrime(-2147483647 - 1));
+    static_assert(isPrime(static_cast<uint64_t>(18446744073709551557ULL)));
+
+    MagicalContainer container;
+    container.addElement(2147483647);
+    container.addElement(2147483646);
+    container.addElement(2147483629);
+    container.addElement(-2147483647);
+    MagicalContainer::PrimeIterator primeIter(container);
+    auto it = primeIter.begin();
+    CHECK(*it == 2147483629);
+    ++it;
+    CHECK(*it == 2147483647);
+    ++it;
+    CHECK(it == primeIter.end());
+}
+
+// Test case for small containers that keep everything inline
+TEST_CASE("Small containers do not allocate") {
+    size_t before = allocation_count;
+    {
+        MagicalContainer container;
+        for (int i = 16; i > 0; --i) {
+            container.addElement(i);
+        }
+        container.removeElement(4);
+        container.addElement(4);
+
+        int sum = 0;
+        MagicalContainer::AscendingIterator asc(container);
+        for (auto it = asc.begin(); it != asc.end(); ++it) {
+            sum += *it;
+        }
+        MagicalContainer::SideCrossIterator cross(container);
+        for (auto it = cross.begin(); it != cross.end(); ++it) {
+            sum += *it;
+        }
+        MagicalContainer::PrimeIterator prime(container);
+        for (auto it = prime.begin(); it != prime.end(); ++it) {
+            sum += *it;
+        }
+        CHECK(sum == 136 + 136 + 41);
+    }
+    CHECK(allocation_count == before);
+
+    {
+        MagicalContainer container;
+        for (int i = 0; i < 17; ++i) {
+            container.addElement(i);
+        }
+        CHECK(allocation_count > before);
+        MagicalContainer copy(container);
+        MagicalContainer moved(std::move(container));
+        copy.removeElement(16);
+        CHECK(copy.size() == 16);
+        CHECK(moved.size() == 17);
+        MagicalContainer::AscendingIterator it(moved);
+        CHECK(*it.end().begin() == 0);
+
+        // the moved-from container is empty and takes new elements
+        CHECK(container.size() == 0);
+        CHECK(container.primeCount() == 0);
+        container.addElement(5);
+        container.addElement(3);
+        container.addElement(5);
+        CHECK(container.size() == 3);
+        MagicalContainer::AscendingIterator reused(container);
+        CHECK(vector<int>(reused.begin(), reused.end()) == vector<int>{3, 5, 5});
+        CHECK(container.primeCount() == 3);
+        container.removeElement(5);
+        CHECK(container.size() == 2);
+
+        // the same with inline elements, and with move assignment
+        MagicalContainer small;
+        for (int i = 0; i < 5; ++i) {
+            small.addElement(i);
+        }
+        MagicalContainer taken(std::move(small));
+        CHECK(small.size() == 0);
+        CHECK(taken.size() == 5);
+        small.addElement(7);
+        MagicalContainer::AscendingIterator smallAsc(small);
+        CHECK(vector<int>(smallAsc.begin(), smallAsc.end()) == vector<int>{7});
+        moved = std::move(taken);
+        CHECK(taken.size() == 0);
+        CHECK(moved.size() == 5);
+        taken.addElement(1);
+        CHECK(taken.size() == 1);
+    }
+
+    before = allocation_count;
+    {
+        BasicMagicalContainer<int, less<int>, 4> tiny;
+        for (int i = 0; i < 100; ++i) {
+            tiny.addElement(i);
+        }
+        BasicMagicalContainer<int, less<int>, 4>::PrimeIterator prime(tiny);
+        CHECK(*prime == 2);
+    }
+    CHECK(allocation_count > before);
+}
+
+TEST_CASE("Containers allocate from their memory resource") {
+    static byte arena[1 << 20];
+    pmr::monotonic_buffer_resource resource(arena, sizeof(arena), pmr::null_memory_resource());
+
+    vector<int> batch = {1001, 1002, 1003, 5, 7};
+    size_t before = allocation_count;
+    {
+        MagicalContainer container(&resource);
+        CHECK(container.memoryResource() == &resource);
+        for (int i = 1000; i > 0; --i) {
+            container.addElement(i);
+        }
+        container.addElements(span<const int>(batch));
+        CHECK(container.size() == 1005);
+        CHECK(container.removeElements(span<const int>(batch)) == 5);
+        CHECK(container.removeIf([](int element) { return element % 2 == 0; }) == 500);
+        container.removeElement(1);
+        CHECK(container.size() == 499);
+
+        MagicalContainer::AscendingIterator asc(container);
+        CHECK(*asc == 3);
+        MagicalContainer::SideCrossIterator cross(container);
+        ++cross;
+        CHECK(*cross == 999);
+        MagicalContainer::PrimeIterator prime(container);
+        CHECK(*prime == 3);
+        int visited = 0;
+        for (auto it = asc.begin(); it != asc.end(); ++it) {
+            ++visited;
+        }
+        CHECK(visited == 499);
+    }
+    CHECK(allocation_count == before);
+
+    // a container without a resource uses the default one
+    MagicalContainer container;
+    CHECK(container.memoryResource() == pmr::get_default_resource());
+}
+
+TEST_CASE("Reserving room and growth policies") {
+    static_assert(DoublingGrowth::grow(0) == 1 && DoublingGrowth::grow(16) == 32);
+    static_assert(HalfAgainGrowth::grow(1) == 2 && HalfAgainGrowth::grow(100) == 150);
+    static_assert(ChunkGrowth<64>::grow(10) == 74);
+
+    MagicalContainer container;
+    container.reserve(1000);
+    CHECK(container.capacity() >= 1000);
+    // even numbers above 2 - the prime tree is not reserved
+    size_t before = allocation_count;
+    for (int i = 0; i < 1000; ++i) {
+        container.addElement(2 * i + 4);
+    }
+    CHECK(allocation_count == before);
+    CHECK(container.size() == 1000);
+
+    for (int i = 0; i < 900; ++i) {
+        container.removeElement(2 * i + 4);
+    }
+    MagicalContainer::AscendingIterator asc(container);
+    ++asc;
+    container.shrink_to_fit();
+    CHECK(container.capacity() >= 100);
+    CHECK(container.capacity() < 1000);
+    CHECK(*asc == 1806);
+    CHECK(container.size() == 100);
+
+    BasicMagicalContainer<int, less<int>, 0, HalfAgainGrowth> half;
+    BasicMagicalContainer<int, less<int>, 0, ChunkGrowth<64>> chunked;
+    for (int i = 500; i > 0; --i) {
+        half.addElement(i);
+        chunked.addElement(i);
+        CHECK(static_cast<int>(half.capacity()) >= half.size());
+        CHECK(static_cast<int>(chunked.capacity()) >= chunked.size());
+    }
+    BasicMagicalContainer<int, less<int>, 0, HalfAgainGrowth>::SideCrossIterator halfCross(half);
+    BasicMagicalContainer<int, less<int>, 0, ChunkGrowth<64>>::SideCrossIterator chunkedCross(chunked);
+    for (int i = 0; i < 500; ++i, ++halfCross, ++chunkedCross) {
+        CHECK(*halfCross == *chunkedCross);
+    }
+    BasicMagicalContainer<int, less<int>, 0, ChunkGrowth<64>>::PrimeIterator prime(chunked);
+    CHECK(*prime == 2);
+}
+
+TEST_CASE("Packed memory array as the sorted index") {
+    using PackedContainer = BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, PackedMemoryArray>;
+    PackedContainer container;
+    vector<int> expected;
+    unsigned int seed = 777;
+    // growing to a few thousand elements, then shrinking back to a few
+    for (int i = 0; i < 12000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        bool removing = !expected.empty() && (i < 8000 ? i % 4 == 3 : i % 4 != 3);
+        if (removing) {
+            int value = expected[(seed >> 8) % expected.size()];
+            container.removeElement(value);
+            expected.erase(find(expected.begin(), expected.end(), value));
+        } else {
+            int value = static_cast<int>((seed >> 16) % 3000);
+            container.addElement(value);
+            expected.push_back(value);
+        }
+        if (i % 1000 == 999) {
+            sort(expected.begin(), expected.end());
+            vector<int> ascending;
+            PackedContainer::AscendingIterator asc(container);
+            for (auto it = asc.begin(); it != asc.end(); ++it) {
+                ascending.push_back(*it);
+            }
+            CHECK(ascending == expected);
+        }
+    }
+    CHECK(container.size() == static_cast<int>(expected.size()));
+
+    // a live iterator sees the element added in front of it when its turn comes
+    PackedContainer live;
+    for (int i = 0; i < 1000; ++i) {
+        live.addElement(2 * i);
+    }
+    PackedContainer::AscendingIterator asc(live);
+    for (int i = 0; i < 500; ++i) {
+        ++asc;
+    }
+    CHECK(*asc == 1000);
+    live.addElement(1001);
+    live.addElement(7);
+    ++asc;
+    CHECK(*asc == 1000);
+    ++asc;
+    CHECK(*asc == 1001);
+    PackedContainer::SideCrossIterator cross(live);
+    ++cross;
+    CHECK(*cross == 1998);
+    PackedContainer::PrimeIterator prime(live);
+    ++prime;
+    CHECK(*prime == 7);
+    ++prime;
+    CHECK(prime == prime.end());
+
+    PackedMemoryArray<int> array;
+    for (int i = 0; i < 5000; ++i) {
+        array.insert(i % 100);
+    }
+    CHECK(array.upperBound(0) == 50);
+    CHECK(array.lowerBound(99) == 4950);
+    CHECK(array.value(array.back()) == 99);
+    for (int i = 0; i < 5000; ++i) {
+        CHECK(array.erase(i % 100));
+    }
+    CHECK(array.empty());
+    CHECK(array.front() == PackedMemoryArray<int>::npos);
+    CHECK_FALSE(array.erase(3));
+
+    // reserving keeps every segment holding an element
+    PackedContainer reserved;
+    for (int value : {50, 10, 40, 20, 30}) {
+        reserved.addElement(value);
+    }
+    reserved.reserve(100000);
+    CHECK(reserved.capacity() >= 100000);
+    for (int value : {-5, 25, 60}) {
+        reserved.addElement(value);
+    }
+    vector<int> ascending;
+    PackedContainer::AscendingIterator reservedAsc(reserved);
+    for (auto it = reservedAsc.begin(); it != reservedAsc.end(); ++it) {
+        ascending.push_back(*it);
+    }
+    CHECK(ascending == vector<int>{-5, 10, 20, 25, 30, 40, 50, 60});
+    reserved.removeElement(25);
+    reserved.removeElement(-5);
+    CHECK(*reservedAsc.begin() == 10);
+    for (int i = 0; i < 5000; ++i) {
+        reserved.addElement(1000 + i);
+    }
+    CHECK(reserved.capacity() >= 100000);
+    for (int i = 0; i < 5000; i += 2) {
+        reserved.removeElement(1000 + i);
+    }
+    CHECK(reserved.size() == 2506);
+    auto it = reservedAsc.begin();
+    it += 6;
+    CHECK(*it == 1001);
+    CHECK(*(reservedAsc.end() - 1) == 5999);
+    reserved.shrink_to_fit();
+    CHECK(reserved.capacity() < 100000);
+    CHECK(*it == 1001);
+
+    // a moved-from array is empty and takes new elements
+    PackedContainer taken(std::move(reserved));
+    CHECK(taken.size() == 2506);
+    CHECK(reserved.size() == 0);
+    for (int value : {9, 4, 9}) {
+        reserved.addElement(value);
+    }
+    PackedContainer::AscendingIterator reusedAsc(reserved);
+    CHECK(vector<int>(reusedAsc.begin(), reusedAsc.end()) == vector<int>{4, 9, 9});
+    reserved = std::move(taken);
+    CHECK(reserved.size() == 2506);
+    CHECK(taken.size() == 0);
+    taken.addElement(1);
+    CHECK(taken.size() == 1);
+}
+
+TEST_CASE("Radix sorting big batches") {
+    unsigned int seed = 99;
+    auto next = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed;
+    };
+    for (size_t size : {0U, 1U, 2U, 127U, 128U, 5000U}) {
+        vector<int> values(size);
+        vector<uint32_t> unsignedValues(size);
+        vector<int> small(size);
+        for (size_t i = 0; i < size; ++i) {
+            values[i] = static_cast<int>(next());
+            unsignedValues[i] = next();
+            small[i] = static_cast<int>(next() % 200) - 100;
+        }
+        if (size > 2) {
+            values[0] = INT32_MIN;
+            values[1] = INT32_MAX;
+            values[2] = 0;
+        }
+        vector<int> expected = values;
+        sort(expected.begin(), expected.end());
+        radixSort(span<int>(values));
+        CHECK(values == expected);
+
+        vector<uint32_t> expectedUnsigned = unsignedValues;
+        sort(expectedUnsigned.begin(), expectedUnsigned.end());
+        radixSort(span<uint32_t>(unsignedValues));
+        CHECK(unsignedValues == expectedUnsigned);
+
+        vector<int> expectedSmall = small;
+        sort(expectedSmall.begin(), expectedSmall.end());
+        radixSort(span<int>(small));
+        CHECK(small == expectedSmall);
+    }
+
+    // a batch above the threshold, negatives first
+    MagicalContainer container;
+    vector<int> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.push_back(i % 2 == 0 ? -i : i);
+    }
+    container.addElements(batch.begin(), batch.end());
+    sort(batch.begin(), batch.end());
+    MagicalContainer::AscendingIterator asc(container);
+    vector<int> ascending;
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        ascending.push_back(*it);
+    }
+    CHECK(ascending == batch);
+    CHECK(container.removeElements(span<const int>(batch)) == 1000);
+    CHECK(container.size() == 0);
+}
+
+TEST_CASE("AscendingIterator is a random access iterator") {
+    static_assert(random_access_iterator<MagicalContainer::AscendingIterator>);
+    static_assert(random_access_iterator<BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, PackedMemoryArray>::AscendingIterator>);
+
+    MagicalContainer container;
+    for (int i = 999; i >= 0; --i) {
+        container.addElement(3 * i);
+    }
+    MagicalContainer::AscendingIterator asc(container);
+    auto first = asc.begin();
+    auto last = asc.end();
+    CHECK(last - first == 1000);
+    CHECK(distance(first, last) == 1000);
+    CHECK(first[500] == 1500);
+    CHECK(*(first + 999) == 2997);
+    CHECK(*(999 + first) == 2997);
+    CHECK(*(last - 1) == 2997);
+    CHECK(last[-1000] == 0);
+    CHECK_THROWS_AS(first[1000], out_of_range);
+    CHECK_THROWS_AS(first + 1001, out_of_range);
+    CHECK_THROWS_AS(first - 1, out_of_range);
+    CHECK_THROWS_AS(--first, runtime_error);
+
+    // binary search and percentiles straight on the ascending view
+    auto found = lower_bound(first, last, 1000);
+    CHECK(*found == 1002);
+    CHECK(found - first == 334);
+    CHECK(binary_search(first, last, 2000) == false);
+    CHECK(binary_search(first, last, 2001) == true);
+    CHECK(*(first + (last - first) * 9 / 10) == 2700);
+
+    auto it = first;
+    it += 10;
+    CHECK(*it == 30);
+    CHECK(*it++ == 30);
+    CHECK(*it == 33);
+    CHECK(*it-- == 33);
+    --it;
+    CHECK(*it == 27);
+    it -= 9;
+    CHECK(it == first);
+    CHECK(first <= it);
+    CHECK(it >= first);
+    CHECK(last > it);
+
+    // stepping back from the end, and seeing an element added meanwhile
+    auto back = asc.end();
+    --back;
+    CHECK(*back == 2997);
+    container.addElement(5000);
+    CHECK(*back == 2997);
+    ++back;
+    CHECK(*back == 5000);
+
+    // a default constructed iterator takes the container it is assigned
+    MagicalContainer::AscendingIterator empty;
+    empty = found;
+    CHECK(*empty == 1002);
+    MagicalContainer other;
+    MagicalContainer::AscendingIterator foreign(other);
+    CHECK_THROWS_AS(foreign = found, runtime_error);
+    CHECK_THROWS_AS((void)(found - foreign), runtime_error);
+
+    // an end() left past the size by removals can only move back
+    MagicalContainer five;
+    for (int i = 1; i <= 5; ++i) {
+        five.addElement(i);
+    }
+    MagicalContainer::AscendingIterator fiveAsc(five);
+    auto stale = fiveAsc.end();
+    for (int i = 1; i <= 3; ++i) {
+        five.removeElement(i);
+    }
+    CHECK_THROWS_AS(stale += 100, out_of_range);
+    CHECK_THROWS_AS(stale += 1, out_of_range);
+    stale -= 4;
+    CHECK(*stale == 5);
+}
+
+TEST_CASE("Seeking the AscendingIterator to a value") {
+    MagicalContainer container;
+    for (int value : {10, 20, 20, 20, 30, 40, -5}) {
+        container.addElement(value);
+    }
+    MagicalContainer::AscendingIterator asc(container);
+    CHECK(*asc.seek_lower(20) == 20);
+    CHECK(asc - asc.begin() == 2);
+    CHECK(*asc.seek_upper(20) == 30);
+    CHECK(*asc.seek_lower(21) == 30);
+    CHECK(*asc.seek_lower(-100) == -5);
+    CHECK(asc.seek_upper(40) == asc.end());
+    CHECK(asc.seek_lower(41) == asc.end());
+
+    auto [first, last] = container.equal_range(20);
+    CHECK(last - first == 3);
+    CHECK(*first == 20);
+    CHECK(*last == 30);
+    auto [missingFirst, missingLast] = container.equal_range(25);
+    CHECK(missingFirst == missingLast);
+    CHECK(*missingFirst == 30);
+
+    // still live after seeking: an element added before the position moves it on
+    asc.seek_lower(30);
+    container.addElement(25);
+    CHECK(*asc == 25);
+    ++asc;
+    CHECK(*asc == 30);
+    container.removeElement(40);
+    ++asc;
+    CHECK(asc == asc.end());
+
+    vector<int> fromTwenty;
+    for (auto it = asc.seek_lower(20); it != asc.end(); ++it) {
+        fromTwenty.push_back(*it);
+    }
+    CHECK(fromTwenty == vector<int>{20, 20, 20, 25, 30});
+}
+
+TEST_CASE("DescendingIterator") {
+    static_assert(bidirectional_iterator<MagicalContainer::DescendingIterator>);
+
+    MagicalContainer container;
+    for (int value : {1, 2, 4, 5, 14, 4}) {
+        container.addElement(value);
+    }
+    MagicalContainer::DescendingIterator desc(container);
+    vector<int> descending;
+    for (auto it = desc.begin(); it != desc.end(); ++it) {
+        descending.push_back(*it);
+    }
+    CHECK(descending == vector<int>{14, 5, 4, 4, 2, 1});
+    CHECK(vector<int>(desc.begin(), desc.end()) == descending);
+
+    // compared by location, like the other iterators
+    auto it14 = desc.begin();
+    auto it5 = desc.begin();
+    ++it5;
+    CHECK(it5 > it14);
+    CHECK(it14 < it5);
+    CHECK(desc.end() > it5);
+
+    auto last = desc.end();
+    --last;
+    CHECK(*last == 1);
+    CHECK(*--last == 2);
+    CHECK(*last-- == 2);
+    CHECK(*last == 4);
+    CHECK_THROWS_AS(--desc.begin(), runtime_error);
+    CHECK_THROWS_AS(++desc.end(), runtime_error);
+    CHECK_THROWS_AS(*desc.end(), out_of_range);
+
+    // live: the position counts from the largest element
+    ++desc;
+    CHECK(*desc == 5);
+    container.addElement(100);
+    CHECK(*desc == 14);
+    container.removeElement(100);
+    container.removeElement(5);
+    CHECK(*desc == 4);
+    ++desc;
+    CHECK(*desc == 4);
+
+    MagicalContainer other;
+    MagicalContainer::DescendingIterator foreign(other);
+    CHECK_THROWS_AS(foreign = desc, runtime_error);
+    CHECK_THROWS_AS((void)(foreign < desc), runtime_error);
+    MagicalContainer::DescendingIterator unattached;
+    unattached = desc;
+    CHECK(unattached == desc);
+
+    MagicalContainer empty;
+    MagicalContainer::DescendingIterator none(empty);
+    CHECK(none.begin() == none.end());
+}
+
+TEST_CASE("Run length multiset mode") {
+    using RunLengthContainer = BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, RunLengthTree>;
+    RunLengthContainer container;
+    vector<int> expected;
+    for (int i = 0; i < 3000; ++i) {
+        int value = (i * 7) % 5 + 1;
+        container.addElement(value);
+        expected.push_back(value);
+    }
+    vector<int> batch(10000, 3);
+    container.addElements(batch.begin(), batch.end());
+    expected.insert(expected.end(), batch.begin(), batch.end());
+    sort(expected.begin(), expected.end());
+    CHECK(container.size() == 13000);
+
+    // every occurrence is still visited
+    RunLengthContainer::AscendingIterator asc(container);
+    CHECK(vector<int>(asc.begin(), asc.end()) == expected);
+    CHECK(asc.begin()[599] == 1);
+    CHECK(asc.begin()[600] == 2);
+    CHECK(*(asc.end() - 1) == 5);
+    auto [low, high] = container.equal_range(3);
+    CHECK(high - low == 10600);
+    RunLengthContainer::DescendingIterator desc(container);
+    CHECK(vector<int>(desc.begin(), desc.end()) == vector<int>(expected.rbegin(), expected.rend()));
+    RunLengthContainer::SideCrossIterator cross(container);
+    vector<int> crossed;
+    for (auto it = cross.begin(); it != cross.end(); ++it) {
+        crossed.push_back(*it);
+    }
+    REQUIRE(crossed.size() == expected.size());
+    CHECK(crossed[0] == 1);
+    CHECK(crossed[1] == 5);
+    CHECK(crossed[6499 * 2] == 3);
+    RunLengthContainer::PrimeIterator prime(container);
+    int fives = 0;
+    for (auto it = prime.begin(); it != prime.end(); ++it) {
+        fives += *it == 5 ? 1 : 0;
+    }
+    CHECK(fives == 600);
+
+    // removing an occurrence only lowers the count
+    for (int i = 0; i < 599; ++i) {
+        container.removeElement(1);
+    }
+    CHECK(*asc.begin() == 1);
+    CHECK(asc.begin()[1] == 2);
+    container.removeElement(1);
+    CHECK(*asc.begin() == 2);
+    CHECK_THROWS_AS(container.removeElement(1), runtime_error);
+    CHECK(container.removeIf([](int value) { return value == 3; }) == 10600);
+    CHECK(container.size() == 1800);
+    CHECK(vector<int>(asc.begin(), asc.end()).back() == 5);
+
+    // one node per distinct value
+    RunLengthTree<int> tree;
+    for (int i = 0; i < 100000; ++i) {
+        tree.insert(i % 4);
+    }
+    CHECK(tree.size() == 100000);
+    CHECK(tree.nodes() == 4);
+    CHECK(tree.capacity() < 16);
+    CHECK(tree.lowerBound(2) == 50000);
+    CHECK(tree.value(tree.select(74999)) == 2);
+    CHECK(tree.value(tree.next(tree.select(74999))) == 3);
+    CHECK(tree.value(tree.prev(tree.select(25000))) == 0);
+    CHECK(tree.value(tree.back()) == 3);
+    vector<int> twos(20000, 2);
+    CHECK(tree.eraseSorted(twos) == 20000);
+    CHECK(tree.upperBound(2) == 55000);
+    for (int i = 0; i < 5000; ++i) {
+        CHECK(tree.erase(2));
+    }
+    CHECK_FALSE(tree.erase(2));
+    CHECK(tree.nodes() == 3);
+    CHECK(tree.size() == 75000);
+    tree.insert(2);
+    CHECK(tree.lowerBound(3) == 50001);
+}
+
+TEST_CASE("Copying elements in batches with next_batch") {
+    MagicalContainer container;
+    for (int i = 0; i < 1000; ++i) {
+        container.addElement((i * 37) % 1001);
+    }
+    MagicalContainer::AscendingIterator asc(container);
+    MagicalContainer::SideCrossIterator cross(container);
+    MagicalContainer::PrimeIterator prime(container);
+    vector<int> ascending;
+    vector<int> crossed;
+    vector<int> primes;
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        ascending.push_back(*it);
+    }
+    for (auto it = cross.begin(); it != cross.end(); ++it) {
+        crossed.push_back(*it);
+    }
+    for (auto it = prime.begin(); it != prime.end(); ++it) {
+        primes.push_back(*it);
+    }
+
+    // every batch size gives the same order as * and ++
+    for (size_t batch : {1U, 2U, 3U, 64U, 999U, 5000U}) {
+        vector<int> buffer(batch);
+        vector<int> copied;
+        MagicalContainer::AscendingIterator a(container);
+        for (size_t count = a.next_batch(buffer); count != 0; count = a.next_batch(buffer)) {
+            copied.insert(copied.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(count));
+        }
+        CHECK(copied == ascending);
+        CHECK(a == asc.end());
+
+        copied.clear();
+        MagicalContainer::SideCrossIterator c(container);
+        for (size_t count = c.next_batch(buffer); count != 0; count = c.next_batch(buffer)) {
+            copied.insert(copied.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(count));
+        }
+        CHECK(copied == crossed);
+        CHECK(c == cross.end());
+
+        copied.clear();
+        MagicalContainer::PrimeIterator p(container);
+        for (size_t count = p.next_batch(buffer); count != 0; count = p.next_batch(buffer)) {
+            copied.insert(copied.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(count));
+        }
+        CHECK(copied == primes);
+        CHECK(p == prime.end());
+    }
+
+    // mixed with ++ and with modifications in between
+    vector<int> buffer(3);
+    ++cross;
+    CHECK(cross.next_batch(buffer) == 3);
+    CHECK(buffer == vector<int>(crossed.begin() + 1, crossed.begin() + 4));
+    CHECK(*cross == crossed[4]);
+    container.addElement(-5);
+    CHECK(asc.next_batch(buffer) == 3);
+    CHECK(buffer == vector<int>{-5, ascending[0], ascending[1]});
+    CHECK(*asc == ascending[2]);
+    ++asc;
+    CHECK(*asc == ascending[3]);
+    CHECK(asc.next_batch(span<int>()) == 0);
+    CHECK(*asc == ascending[3]);
+
+    // the packed memory array and the run length tree copy whole blocks
+    using PackedContainer = BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, PackedMemoryArray>;
+    using RunLengthContainer = BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, RunLengthTree>;
+    PackedContainer packed;
+    RunLengthContainer runs;
+    vector<int> expected;
+    for (int i = 0; i < 3000; ++i) {
+        packed.addElement(i % 50);
+        runs.addElement(i % 50);
+        expected.push_back(i % 50);
+    }
+    sort(expected.begin(), expected.end());
+    vector<int> block(1000);
+    PackedContainer::AscendingIterator packedIt(packed);
+    RunLengthContainer::AscendingIterator runsIt(runs);
+    ++packedIt;
+    ++runsIt;
+    CHECK(packedIt.next_batch(block) == 1000);
+    CHECK(block == vector<int>(expected.begin() + 1, expected.begin() + 1001));
+    CHECK(runsIt.next_batch(block) == 1000);
+    CHECK(block == vector<int>(expected.begin() + 1, expected.begin() + 1001));
+    CHECK(*runsIt == expected[1001]);
+    CHECK(packedIt.next_batch(block) == 1000);
+    CHECK(packedIt.next_batch(block) == 999);
+    CHECK(block[998] == 49);
+    CHECK(packedIt == packedIt.end());
+}
+
+TEST_CASE("Bounded views of a value window") {
+    MagicalContainer container;
+    for (int i = 1; i <= 100; ++i) {
+        container.addElement(i);
+    }
+    container.addElement(20);
+
+    MagicalContainer::AscendingIterator window(container, 10, 21);
+    CHECK(*window == 10);
+    CHECK(vector<int>(window.begin(), window.end()) == vector<int>{10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 20});
+    CHECK(window.end() - window.begin() == 12);
+    CHECK(*(window.end() - 1) == 20);
+    vector<int> buffer(100);
+    CHECK(window.next_batch(buffer) == 12);
+    CHECK(buffer[11] == 20);
+    CHECK(window == window.end());
+    CHECK(window.next_batch(buffer) == 0);
+
+    // bounds that are not elements, and empty windows
+    MagicalContainer::AscendingIterator between(container, -5, 3);
+    CHECK(vector<int>(between.begin(), between.end()) == vector<int>{1, 2});
+    MagicalContainer::AscendingIterator empty(container, 50, 50);
+    CHECK(empty.begin() == empty.end());
+    MagicalContainer::AscendingIterator reversed(container, 60, 40);
+    CHECK(reversed.begin() == reversed.end());
+    MagicalContainer::AscendingIterator above(container, 200, 300);
+    CHECK(above.begin() == above.end());
+
+    // the window follows the container
+    MagicalContainer::AscendingIterator live(container, 95, 1000);
+    container.addElement(500);
+    container.removeElement(96);
+    CHECK(vector<int>(live.begin(), live.end()) == vector<int>{95, 97, 98, 99, 100, 500});
+    MagicalContainer::AscendingIterator copy = live;
+    CHECK(vector<int>(copy.begin(), copy.end()).size() == 6);
+
+    MagicalContainer::PrimeIterator primes(container, 10, 30);
+    CHECK(*primes == 11);
+    vector<int> found;
+    for (auto it = primes.begin(); it != primes.end(); ++it) {
+        found.push_back(*it);
+    }
+    CHECK(found == vector<int>{11, 13, 17, 19, 23, 29});
+    CHECK(primes.next_batch(buffer) == 6);
+    CHECK(primes == primes.end());
+    container.addElement(29);
+    CHECK(primes.end() > primes);
+    CHECK(*primes == 29);
+    MagicalContainer::PrimeIterator none(container, 24, 29);
+    CHECK(none.begin() == none.end());
+
+    // stepping, jumping and reading past the window throws
+    MagicalContainer ten;
+    for (int i = 1; i <= 10; ++i) {
+        ten.addElement(i);
+    }
+    MagicalContainer::AscendingIterator w(ten, 3, 6);
+    CHECK_THROWS_AS(++w.end(), runtime_error);
+    CHECK_THROWS_AS(--w.begin(), runtime_error);
+    CHECK_THROWS_AS(w.begin() += 4, out_of_range);
+    CHECK_THROWS_AS(w.begin() -= 1, out_of_range);
+    CHECK_THROWS_AS((void)w.begin()[3], out_of_range);
+    CHECK_THROWS_AS((void)w.begin()[-1], out_of_range);
+    CHECK_THROWS_AS((void)*w.end(), out_of_range);
+    CHECK(*(w.begin() += 2) == 5);
+    CHECK(w.begin()[2] == 5);
+    CHECK(*(w.end() - 3) == 3);
+    // seeking stays inside the window too
+    CHECK(w.begin().seek_lower(9) == w.end());
+    CHECK(w.begin().seek_upper(100) == w.end());
+    CHECK(*w.end().seek_lower(-7) == 3);
+    CHECK(*w.begin().seek_upper(3) == 4);
+    vector<int> rest;
+    for (auto seeked = w.begin().seek_lower(4); seeked != w.end(); ++seeked) {
+        rest.push_back(*seeked);
+    }
+    CHECK(rest == vector<int>{4, 5});
+    // an element added below lo moves the window, not the position
+    auto inside = w.begin();
+    ten.addElement(0);
+    CHECK_THROWS_AS((void)*inside, out_of_range);
+    ++inside;
+    CHECK(*inside == 3);
+
+    MagicalContainer::PrimeIterator pw(ten, 3, 6);
+    CHECK(vector<int>{*pw, pw.begin()[1]} == vector<int>{3, 5});
+    CHECK_THROWS_AS(++pw.end(), runtime_error);
+    CHECK_THROWS_AS(--pw.begin(), runtime_error);
+    CHECK_THROWS_AS(pw.begin() += 3, out_of_range);
+    CHECK_THROWS_AS((void)pw.begin()[2], out_of_range);
+    CHECK_THROWS_AS((void)*pw.end(), out_of_range);
+    CHECK(pw.end() - pw.begin() == 2);
+}
+
+TEST_CASE("MergedAscendingIterator over many containers") {
+    vector<MagicalContainer> shards(13);
+    vector<MagicalContainer*> pointers;
+    vector<int> expected;
+    unsigned int seed = 99;
+    for (size_t shard = 0; shard < shards.size(); ++shard) {
+        pointers.push_back(&shards[shard]);
+        // one shard stays empty
+        for (size_t i = 0; shard != 5 && i < 40 + 7 * shard; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int value = static_cast<int>((seed >> 16) % 500);
+            shards[shard].addElement(value);
+            expected.push_back(value);
+        }
+    }
+    sort(expected.begin(), expected.end());
+
+    MagicalContainer::MergedAscendingIterator merged(pointers);
+    vector<int> streamed;
+    for (auto it = merged.begin(); it != merged.end(); ++it) {
+        streamed.push_back(*it);
+    }
+    CHECK(streamed == expected);
+    CHECK(merged.begin() < merged.end());
+    CHECK_THROWS_AS(*merged.end(), out_of_range);
+    auto last = merged.end();
+    CHECK_THROWS_AS(++last, runtime_error);
+
+    // equal elements come out in the order of their containers
+    MagicalContainer first;
+    MagicalContainer second;
+    first.addElement(7);
+    second.addElement(7);
+    second.addElement(3);
+    MagicalContainer::MergedAscendingIterator pair({&second, &first});
+    CHECK(*pair == 3);
+    ++pair;
+    CHECK(&*pair == &*MagicalContainer::AscendingIterator(second).seek_lower(7));
+    ++pair;
+    CHECK(&*pair == &*MagicalContainer::AscendingIterator(first));
+    ++pair;
+    CHECK(pair == pair.end());
+
+    // live: the modified containers are noticed on the next step
+    MagicalContainer::MergedAscendingIterator live({&first, &second});
+    CHECK(*live == 3);
+    ++live;
+    first.addElement(5);
+    second.addElement(100);
+    first.addElement(1000);
+    vector<int> rest;
+    for (; live != live.end(); ++live) {
+        rest.push_back(*live);
+    }
+    CHECK(rest == vector<int>{5, 7, 7, 100, 1000});
+
+    // comparing iterators of other containers throws
+    MagicalContainer::MergedAscendingIterator other({&first});
+    CHECK_THROWS_AS((void)(other < live), runtime_error);
+    CHECK_THROWS_AS(other = live, runtime_error);
+    CHECK_FALSE(other == live);
+    MagicalContainer::MergedAscendingIterator same({&first, &second});
+    same = live;
+    CHECK(same == live);
+
+    MagicalContainer::MergedAscendingIterator none(vector<MagicalContainer*>{});
+    CHECK(none.begin() == none.end());
+    CHECK_THROWS_AS(*none, out_of_range);
+}
+
+TEST_CASE("Bounded universe index") {
+    using UniverseContainer = BasicMagicalContainer<int, less<int>, 16, DoublingGrowth, BoundedUniverse<24>::Index>;
+    UniverseContainer container;
+    vector<int> expected;
+    unsigned int seed = 4242;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        bool removing = !expected.empty() && i % 3 == 2;
+        if (removing) {
+            int value = expected[(seed >> 8) % expected.size()];
+            container.removeElement(value);
+            expected.erase(find(expected.begin(), expected.end(), value));
+        } else {
+            // clustered values, so some are repeated and some words are full
+            int value = static_cast<int>((seed >> 8) % 4000) * (i % 2 == 0 ? 1 : 4001);
+            container.addElement(value);
+            expected.push_back(value);
+        }
+    }
+    sort(expected.begin(), expected.end());
+    UniverseContainer::AscendingIterator asc(container);
+    CHECK(vector<int>(asc.begin(), asc.end()) == expected);
+    CHECK(container.size() == static_cast<int>(expected.size()));
+    for (size_t rank : {0U, 1U, 777U, 5000U}) {
+        CHECK(asc.begin()[static_cast<ptrdiff_t>(rank)] == expected[rank]);
+    }
+    CHECK(asc.end()[-1] == expected.back());
+    for (int value : {0, 5, 3999, 4001, 8002, 16000000, (1 << 24) - 1, 1 << 24, -3}) {
+        auto lower = static_cast<ptrdiff_t>(lower_bound(expected.begin(), expected.end(), value) - expected.begin());
+        auto upper = static_cast<ptrdiff_t>(upper_bound(expected.begin(), expected.end(), value) - expected.begin());
+        auto [first, last] = container.equal_range(value);
+        CHECK(first - asc.begin() == lower);
+        CHECK(last - asc.begin() == upper);
+    }
+    UniverseContainer::DescendingIterator desc(container);
+    CHECK(vector<int>(desc.begin(), desc.end()) == vector<int>(expected.rbegin(), expected.rend()));
+    UniverseContainer::PrimeIterator prime(container);
+    vector<int> primes;
+    copy_if(expected.begin(), expected.end(), back_inserter(primes), [](int value) { return isPrime(value); });
+    vector<int> found;
+    for (auto it = prime.begin(); it != prime.end(); ++it) {
+        found.push_back(*it);
+    }
+    CHECK(found == primes);
+    vector<int> buffer(expected.size());
+    UniverseContainer::AscendingIterator batch(container);
+    CHECK(batch.next_batch(buffer) == expected.size());
+    CHECK(buffer == expected);
+
+    // outside the universe nothing changes
+    int size = container.size();
+    CHECK_THROWS_AS(container.addElement(1 << 24), out_of_range);
+    CHECK_THROWS_AS(container.addElement(-1), out_of_range);
+    vector<int> some{1, 2, 1 << 25};
+    CHECK_THROWS_AS(container.addElements(some.begin(), some.end()), out_of_range);
+    CHECK(container.size() == size);
+    CHECK_THROWS_AS(container.removeElement(1 << 24), runtime_error);
+    container.addElement((1 << 24) - 1);
+    CHECK(*(asc.end() - 1) == (1 << 24) - 1);
+
+    CHECK(container.removeIf([](int value) { return value % 2 == 0; }) == static_cast<size_t>(count_if(expected.begin(), expected.end(), [](int value) { return value % 2 == 0; })));
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        CHECK(*it % 2 == 1);
+    }
+
+    BoundedUniverseIndex<int, less<int>, 0, DoublingGrowth, 12> small;
+    CHECK(small.front() == small.npos);
+    CHECK(small.lowerBound(100) == 0);
+    small.insert(4095);
+    small.insert(0);
+    small.insert(0);
+    CHECK(small.value(small.back()) == 4095);
+    CHECK(small.value(small.next(small.front())) == 0);
+    CHECK(small.value(small.prev(small.back())) == 0);
+    CHECK(small.upperBound(0) == 2);
+    CHECK(small.upperBound(4095) == 3);
+    CHECK(small.erase(0));
+    CHECK(small.erase(0));
+    CHECK_FALSE(small.erase(0));
+    CHECK(small.select(0) == small.back());
+
+    // a moved-from index is empty and takes new elements
+    UniverseContainer taken(std::move(container));
+    CHECK(container.size() == 0);
+    CHECK(taken.size() > 0);
+    container.addElement(12);
+    container.addElement(3);
+    UniverseContainer::AscendingIterator reused(container);
+    CHECK(vector<int>(reused.begin(), reused.end()) == vector<int>{3, 12});
+    container = std::move(taken);
+    CHECK(taken.size() == 0);
+    CHECK(*container.equal_range((1 << 24) - 1).first == (1 << 24) - 1);
+    taken.addElement(5);
+    CHECK(taken.size() == 1);
+}
+
+TEST_CASE("Primality is tested once per distinct value") {
+    HashIndex<int> index;
+    int calls = 0;
+    auto classify = [&calls](int value) {
+        ++calls;
+        return isPrime(value);
+    };
+    for (int round = 0; round < 3; ++round) {
+        for (int value = 0; value < 1000; ++value) {
+            CHECK(index.add(value, classify) == isPrime(value));
+        }
+    }
+    CHECK(calls == 1000);
+    // the marks move with their keys when the table grows and when
+    // removals shift the clusters back
+    for (int value = 0; value < 1000; value += 2) {
+        for (int round = 0; round < 3; ++round) {
+            bool marked = false;
+            CHECK(index.remove(value, marked));
+            CHECK(marked == isPrime(value));
+        }
+    }
+    bool allMarksRight = true;
+    for (int value = 1; value < 1000; value += 2) {
+        for (int round = 0; round < 3; ++round) {
+            bool marked = false;
+            allMarksRight = allMarksRight && index.remove(value, marked) && marked == isPrime(value);
+        }
+    }
+    CHECK(allMarksRight);
+    bool marked = true;
+    CHECK_FALSE(index.remove(1, marked));
+    CHECK(index.add(7, classify));
+    CHECK(calls == 1001);
+
+    // a moved-from index is empty and hashes into its own table again
+    for (int value = 0; value < 100; ++value) {
+        index.add(value, classify);
+    }
+    HashIndex<int> moved(std::move(index));
+    CHECK(moved.size() == 100);
+    CHECK(moved.count(50) == 1);
+    CHECK(index.size() == 0);
+    CHECK(index.count(50) == 0);
+    CHECK_FALSE(index.remove(50));
+    index.add(50);
+    index.add(50);
+    CHECK(index.size() == 1);
+    CHECK(index.count(50) == 2);
+    moved = std::move(index);
+    CHECK(moved.size() == 1);
+    CHECK(index.size() == 0);
+    index.add(3);
+    CHECK(index.count(3) == 1);
+
+    MagicalContainer container;
+    vector<int> batch = {13, 4, 13, 2147483647, 9, 2, 4, 2147483647};
+    container.addElements(span<const int>(batch));
+    container.addElement(13);
+    container.removeElement(2147483647);
+    container.removeElements(vector<int>{13, 4, 2});
+    container.removeIf([](int element) { return element == 9; });
+    vector<int> primes;
+    MagicalContainer::PrimeIterator primeIter(container);
+    for (auto it = primeIter.begin(); it != primeIter.end(); ++it) {
+        primes.push_back(*it);
+    }
+    CHECK(primes == vector<int>{13, 13, 2147483647});
+    CHECK(container.size() == 4);
+}
+
+TEST_CASE("Sieve table and segmented sieve") {
+    const uint32_t bound = 1U << 20U;
+    vector<bool> composite(bound, false);
+    for (uint32_t i = 2; i * i < bound; ++i) {
+        for (uint32_t multiple = i * i; !composite[i] && multiple < bound; multiple += i) {
+            composite[multiple] = true;
+        }
+    }
+    bool tableRight = true;
+    for (uint32_t value = 0; value < bound; ++value) {
+        tableRight = tableRight && isPrime(value) == (value >= 2 && !composite[value]);
+    }
+    CHECK(tableRight);
+    static_assert(isPrime(1048573) && !isPrime(1048575) && isPrime(static_cast<uint16_t>(65521)));
+
+    // windows that start inside the table, cross its bound, and sit near 2^31 and 2^39
+    bool sieveRight = true;
+    for (int lo : {-100, 0, 1048000, 2147483647 - 400000}) {
+        int hi = lo + 400000 < 0 ? 2147483647 : lo + 400000;
+        PrimeSieve<int> sieve(lo, hi);
+        for (int value = lo; value < hi; ++value) {
+            sieveRight = sieveRight && sieve.contains(value) == isPrime(value);
+        }
+        sieveRight = sieveRight && sieve.contains(hi) == isPrime(hi) && sieve.contains(lo - 7) == isPrime(lo - 7);
+    }
+    uint64_t wide = (1ULL << 39U) - 1000;
+    PrimeSieve<uint64_t> wideSieve(wide, wide + 100000);
+    for (uint64_t value = wide; value <= wide + 100000; ++value) {
+        sieveRight = sieveRight && wideSieve.contains(value) == isPrime(value);
+    }
+    CHECK(sieveRight);
+    CHECK_FALSE(PrimeSieve<int>::suits(100, 2000000, 2000100));
+    CHECK(PrimeSieve<int>::suits(100000, 2000000, 2100000));
+    CHECK_FALSE(PrimeSieve<int>::suits(100000, 0, 2100000000));
+    CHECK_FALSE(PrimeSieve<int>::suits(100000, 0, 1000));
+
+    // a sieved batch ends up like elements added one by one
+    vector<int> values;
+    for (int value = 2000000000; value < 2000000000 + 60000; value += 3) {
+        values.push_back(value);
+        values.push_back(-value);
+    }
+    REQUIRE(PrimeSieve<int>::suits(values.size(), 2000000000, 2000000000 + 60000));
+    MagicalContainer batched;
+    MagicalContainer single;
+    batched.addElement(2000000011);
+    single.addElement(2000000011);
+    batched.addElements(values.begin(), values.end());
+    for (int value : values) {
+        single.addElement(value);
+    }
+    MagicalContainer::PrimeIterator batchedPrimes(batched);
+    MagicalContainer::PrimeIterator singlePrimes(single);
+    vector<int> fromBatch;
+    vector<int> fromSingle;
+    for (auto it = batchedPrimes.begin(); it != batchedPrimes.end(); ++it) {
+        fromBatch.push_back(*it);
+    }
+    for (auto it = singlePrimes.begin(); it != singlePrimes.end(); ++it) {
+        fromSingle.push_back(*it);
+    }
+    CHECK(fromBatch.size() > 500);
+    CHECK(fromBatch == fromSingle);
+}
+
+TEST_CASE("Batch primality matches isPrime") {
+    vector<int> values = {0, 1, 2, 3, 4, -1, -2, -3, -2147483647 - 1, 2147483647, 2147483629, 2047, 1048573, 1048575,
+                          1048576, 1048583, 1046527, 65521, 65537, 4759123, 25326001, 1373653, 561, 1105};
+    uint32_t state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 1664525U + 1013904223U;
+        values.push_back(static_cast<int>(state));
+        values.push_back(static_cast<int>(state >> 1U) | 1);
+        values.push_back(static_cast<int>(state % 3000000U));
+    }
+    // every length, so the groups of 8 and the candidate groups end anywhere
+    bool allMatch = true;
+    for (size_t length : {size_t{0}, size_t{1}, size_t{7}, size_t{8}, size_t{9}, size_t{23}, values.size()}) {
+        vector<uint8_t> flags(length, 2);
+        isPrimeBatch(span<const int>(values.data(), length), span<uint8_t>(flags));
+        for (size_t i = 0; i < length; ++i) {
+            allMatch = allMatch && flags[i] == (isPrime(values[i]) ? 1 : 0);
+        }
+    }
+    vector<uint32_t> wide;
+    for (uint32_t value = 4294967295U - 20000; value != 0; ++value) {
+        wide.push_back(value);
+    }
+    vector<uint8_t> wideFlags(wide.size());
+    isPrimeBatch(span<const uint32_t>(wide), span<uint8_t>(wideFlags));
+    for (size_t i = 0; i < wide.size(); ++i) {
+        allMatch = allMatch && wideFlags[i] == (isPrime(wide[i]) ? 1 : 0);
+    }
+    vector<int64_t> longValues = {-5, 0, 2, 4294967311LL, 4294967311LL * 3};
+    vector<uint8_t> longFlags(longValues.size());
+    isPrimeBatch(span<const int64_t>(longValues), span<uint8_t>(longFlags));
+    CHECK(longFlags == vector<uint8_t>{0, 0, 1, 1, 0});
+    CHECK_FALSE(isPrimeBatchVectorized<int64_t>());
+    CHECK(allMatch);
+
+    // a sparse batch (no sieve) ends up like elements added one by one
+    REQUIRE_FALSE(PrimeSieve<int>::suits(values.size(), 2, 2147483647));
+    MagicalContainer batched;
+    MagicalContainer single;
+    batched.addElements(values.begin(), values.end());
+    for (int value : values) {
+        single.addElement(value);
+    }
+    MagicalContainer::PrimeIterator batchedPrimes(batched);
+    MagicalContainer::PrimeIterator singlePrimes(single);
+    auto it = batchedPrimes.begin();
+    auto other = singlePrimes.begin();
+    bool sameElements = true;
+    for (; it != batchedPrimes.end() && other != singlePrimes.end(); ++it, ++other) {
+        sameElements = sameElements && *it == *other;
+    }
+    CHECK(sameElements);
+    CHECK(it == batchedPrimes.end());
+    CHECK(other == singlePrimes.end());
+}
+
+TEST_CASE("Random access PrimeIterator and primeCount") {
+    MagicalContainer container;
+    CHECK(container.primeCount() == 0);
+    for (int value = 1; value <= 30; ++value) {
+        container.addElement(value);
+    }
+    // 2 3 5 7 11 13 17 19 23 29
+    CHECK(container.primeCount() == 10);
+    container.removeElement(4);
+    container.removeElement(13);
+    CHECK(container.primeCount() == 9);
+    vector<int> batch = {31, 37, 38, 41};
+    container.addElements(batch.begin(), batch.end());
+    CHECK(container.primeCount() == 12);
+    CHECK(container.removeIf([](int value) { return value > 36; }) == 3);
+    CHECK(container.primeCount() == 10);
+
+    MagicalContainer::PrimeIterator primes(container);
+    auto it = primes.begin();
+    CHECK(it[0] == 2);
+    CHECK(it[9] == 31);
+    it += 4;
+    CHECK(*it == 11);
+    CHECK(it[-1] == 7);
+    CHECK(*(it - 2) == 5);
+    CHECK(*(2 + it) == 19);
+    CHECK(*it-- == 11);
+    CHECK(*it == 7);
+    CHECK(*--it == 5);
+    CHECK(*it++ == 5);
+    CHECK(*it == 7);
+    CHECK(primes.end() - it == 7);
+    CHECK(it - primes.begin() == 3);
+    CHECK(primes.begin() <= it);
+    CHECK(primes.end() >= it);
+    CHECK_THROWS_AS(it += 8, std::out_of_range);
+    CHECK_THROWS_AS(it -= 4, std::out_of_range);
+    CHECK_THROWS_AS((void)it[7], std::out_of_range);
+    CHECK(*it == 7);
+    auto last = primes.end();
+    --last;
+    CHECK(*last == 31);
+    CHECK_THROWS_AS(--primes.begin(), std::runtime_error);
+
+    // live: the iterator keeps its rank, a prime added before it shifts the rest
+    container.addElement(3);
+    container.addElement(43);
+    CHECK(container.primeCount() == 12);
+    CHECK(it[-1] == 3);
+    CHECK(it[0] == 5);
+    CHECK(primes.end() - primes.begin() == 12);
+    CHECK(primes.begin()[11] == 43);
+
+    // the standard algorithms see a random access iterator
+    CHECK(std::distance(primes.begin(), primes.end()) == 12);
+    CHECK(std::count_if(primes.begin(), primes.end(), [](int value) { return value > 20; }) == 4);
+    static_assert(std::is_same_v<std::iterator_traits<MagicalContainer::PrimeIterator>::iterator_category, std::random_access_iterator_tag>);
+}
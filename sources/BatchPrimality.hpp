@@ -0,0 +1,286 @@
+/*                       BatchPrimality.hpp
+   ======================================================================
+   This header file defines isPrimeBatch(), which classifies a whole
+   batch of elements at once: primes[i] is 1 when values[i] is a prime,
+   exactly as isPrime(values[i]) would say.
+
+   For 32 bit elements on x86 with AVX2 (checked at run time) it works
+   on 8 lanes at a time, in two passes:
+   1. Every group of 8 values is looked up in the compile time table of
+      Primality.hpp with one gather (the values below its bound), and
+      the bigger values are tested for the odd primes below 256 by
+      multiplying with the inverse of the prime modulo 2^32: p divides x
+      exactly when x * (1/p) mod 2^32 <= (2^32 - 1) / p, a multiplication
+      and a comparison per prime instead of a division. What is left
+      (about one value in ten) is collected as a candidate.
+   2. The candidates go through the Miller-Rabin test of isPrime (the
+      witnesses 2, 7 and 61) 8 at a time. The products are Montgomery
+      multiplications (modulo n with R = 2^32, no division at all), in
+      the 64 bit lanes of _mm256_mul_epu32, so the 8 candidates are two
+      vectors of 4 that are worked on side by side.
+   Both passes are exact, so the result is bit for bit the one of the
+   scalar path. Other element types, and machines without AVX2, call
+   isPrime for every element.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "Primality.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ARIEL_PRIMALITY_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace ariel {
+
+template <typename T>
+concept BatchPrimeTestable = PrimeTestable<T> && sizeof(T) == sizeof(std::uint32_t);
+
+namespace primality {
+
+    // 1 / n modulo 2^32 for an odd n, by Newton's iteration
+    constexpr std::uint32_t inverse32(std::uint32_t n) {
+        std::uint32_t inverse = n;  // right in the lowest 3 bits
+        for (int step = 0; step < 4; ++step) {
+            inverse *= 2U - n * inverse;
+        }
+        return inverse;
+    }
+
+    // p divides x exactly when x * inverse (mod 2^32) <= limit
+    struct Divisor {
+        std::uint32_t inverse;
+        std::uint32_t limit;
+    };
+
+    // the odd primes below 256
+    inline constexpr std::array<Divisor, 53> odd_divisors = [] {
+        std::array<Divisor, 53> divisors{};
+        for (std::size_t i = 1; i < primes_below_256.size(); ++i) {
+            std::uint32_t prime = primes_below_256[i];
+            divisors[i - 1] = Divisor{inverse32(prime), UINT32_MAX / prime};
+        }
+        return divisors;
+    }();
+
+    // from this many elements the container classifies a batch with isPrimeBatch (see Bench.cpp)
+    inline constexpr std::size_t batch_threshold = 32;
+
+#ifdef ARIEL_PRIMALITY_AVX2
+    inline bool hasAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2") != 0;
+        return supported;
+    }
+
+    /* a * b / 2^32 modulo n for 4 numbers below n < 2^32, one in every 64
+       bit lane. inverse is 1 / n modulo 2^32. the low halves of a * b and
+       of m * n, m = (a * b) * inverse, are the same, so the difference of
+       the high halves is the result, give or take n. */
+    __attribute__((target("avx2"))) inline __m256i montgomeryMultiply(__m256i a, __m256i b, __m256i n, __m256i inverse) {
+        __m256i product = _mm256_mul_epu32(a, b);
+        __m256i multiple = _mm256_mul_epu32(_mm256_mul_epu32(product, inverse), n);
+        __m256i reduced = _mm256_sub_epi64(_mm256_srli_epi64(product, 32), _mm256_srli_epi64(multiple, 32));
+        __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), reduced);
+        return _mm256_add_epi64(reduced, _mm256_and_si256(negative, n));
+    }
+
+    // 4 candidates in 64 bit lanes, with what the Miller-Rabin test needs
+    struct MontgomeryLanes {
+        __m256i n;
+        __m256i inverse;
+        __m256i one;       // R mod n, 1 in Montgomery form
+        __m256i minusOne;  // n - 1 in Montgomery form
+        __m256i square;    // R^2 mod n, turns a number into Montgomery form
+        __m256i odd;       // n - 1 = odd * 2^squarings
+        __m256i squarings;
+    };
+
+    /* the 8 candidates (odd, above 65536, without a factor below 256)
+       that are primes, as a mask of 8 bits */
+    __attribute__((target("avx2"))) inline unsigned millerRabin8(const std::uint32_t* candidates) {
+        alignas(32) std::uint64_t fields[7][8];
+        unsigned bits = 0;
+        std::uint64_t mostSquarings = 0;
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            std::uint64_t n = candidates[lane];
+            std::uint64_t one = (std::uint64_t{1} << 32U) % n;
+            auto squarings = static_cast<unsigned>(std::countr_zero(n - 1));
+            fields[0][lane] = n;
+            fields[1][lane] = inverse32(candidates[lane]);
+            fields[2][lane] = one;
+            fields[3][lane] = n - one;
+            fields[4][lane] = one * one % n;
+            fields[5][lane] = (n - 1) >> squarings;
+            fields[6][lane] = squarings;
+            bits = std::max(bits, static_cast<unsigned>(std::bit_width(fields[5][lane])));
+            mostSquarings = std::max<std::uint64_t>(mostSquarings, squarings);
+        }
+        MontgomeryLanes halves[2];
+        for (std::size_t half = 0; half < 2; ++half) {
+            __m256i loaded[7];
+            for (std::size_t field = 0; field < 7; ++field) {
+                loaded[field] = _mm256_load_si256(reinterpret_cast<const __m256i*>(fields[field] + 4 * half));
+            }
+            halves[half] = MontgomeryLanes{loaded[0], loaded[1], loaded[2], loaded[3], loaded[4], loaded[5], loaded[6]};
+        }
+
+        // the witnesses share the exponent, so the 3 witnesses of the 2
+        // halves are 6 independent chains of multiplications
+        constexpr std::size_t chains = witnesses32.size();
+        __m256i power[chains][2];
+        __m256i base[chains][2];
+        for (std::size_t chain = 0; chain < chains; ++chain) {
+            for (std::size_t half = 0; half < 2; ++half) {
+                const MontgomeryLanes& lanes = halves[half];
+                base[chain][half] = montgomeryMultiply(_mm256_set1_epi64x(witnesses32[chain]), lanes.square, lanes.n, lanes.inverse);
+                power[chain][half] = lanes.one;
+            }
+        }
+        // witness^odd, from the highest bit of the exponents down
+        for (unsigned bit = bits; bit-- > 0;) {
+            __m256i shift = _mm256_set1_epi64x(bit);
+            for (std::size_t half = 0; half < 2; ++half) {
+                const MontgomeryLanes& lanes = halves[half];
+                __m256i set = _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(_mm256_srlv_epi64(lanes.odd, shift), _mm256_set1_epi64x(1)));
+                for (std::size_t chain = 0; chain < chains; ++chain) {
+                    __m256i squared = montgomeryMultiply(power[chain][half], power[chain][half], lanes.n, lanes.inverse);
+                    __m256i multiplied = montgomeryMultiply(squared, base[chain][half], lanes.n, lanes.inverse);
+                    power[chain][half] = _mm256_blendv_epi8(squared, multiplied, set);
+                }
+            }
+        }
+        // a prime passes every witness: witness^odd is 1 or -1, or one of
+        // the next squarings is -1
+        __m256i prime[2];
+        for (std::size_t half = 0; half < 2; ++half) {
+            const MontgomeryLanes& lanes = halves[half];
+            __m256i passed[chains];
+            for (std::size_t chain = 0; chain < chains; ++chain) {
+                passed[chain] = _mm256_or_si256(_mm256_cmpeq_epi64(power[chain][half], lanes.one), _mm256_cmpeq_epi64(power[chain][half], lanes.minusOne));
+            }
+            for (std::uint64_t round = 1; round < mostSquarings; ++round) {
+                __m256i inTime = _mm256_cmpgt_epi64(lanes.squarings, _mm256_set1_epi64x(static_cast<long long>(round)));
+                for (std::size_t chain = 0; chain < chains; ++chain) {
+                    power[chain][half] = montgomeryMultiply(power[chain][half], power[chain][half], lanes.n, lanes.inverse);
+                    passed[chain] = _mm256_or_si256(passed[chain], _mm256_and_si256(inTime, _mm256_cmpeq_epi64(power[chain][half], lanes.minusOne)));
+                }
+            }
+            prime[half] = passed[0];
+            for (std::size_t chain = 1; chain < chains; ++chain) {
+                prime[half] = _mm256_and_si256(prime[half], passed[chain]);
+            }
+        }
+        auto low = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(prime[0])));
+        auto high = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(prime[1])));
+        return low | high << 4U;
+    }
+
+    template <BatchPrimeTestable T>
+    __attribute__((target("avx2"))) void isPrimeBatchAvx2(std::span<const T> values, std::span<std::uint8_t> primes, std::pmr::memory_resource* resource) {
+        const __m256i lastTabled = _mm256_set1_epi32(static_cast<int>(std::min<std::uint64_t>(table_bound - 1, UINT32_MAX)));
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i two = _mm256_set1_epi32(2);
+        std::pmr::vector<std::uint32_t> candidates(resource);
+        std::pmr::vector<std::size_t> positions(resource);
+
+        std::size_t i = 0;
+        for (; i + 8 <= values.size(); i += 8) {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values.data() + i));
+            __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(value, one), one);
+            __m256i tabled = _mm256_cmpeq_epi32(_mm256_min_epu32(value, lastTabled), value);
+            // bit (value / 2) % 32 of the 32 bit table word value / 64
+            __m256i index = _mm256_and_si256(_mm256_srli_epi32(value, 6), tabled);
+            __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table.words), index, 4);
+            __m256i shift = _mm256_and_si256(_mm256_srli_epi32(value, 1), _mm256_set1_epi32(31));
+            __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(words, shift), one);
+            __m256i prime = _mm256_and_si256(tabled, _mm256_or_si256(_mm256_and_si256(odd, _mm256_cmpeq_epi32(bit, one)), _mm256_cmpeq_epi32(value, two)));
+
+            __m256i candidate = _mm256_andnot_si256(tabled, odd);
+            if constexpr (std::is_signed_v<T>) {
+                candidate = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), value), candidate);
+            }
+            if (!_mm256_testz_si256(candidate, candidate)) {
+                for (const Divisor& divisor : odd_divisors) {
+                    __m256i quotient = _mm256_mullo_epi32(value, _mm256_set1_epi32(static_cast<int>(divisor.inverse)));
+                    __m256i divisible = _mm256_cmpeq_epi32(_mm256_min_epu32(quotient, _mm256_set1_epi32(static_cast<int>(divisor.limit))), quotient);
+                    candidate = _mm256_andnot_si256(divisible, candidate);
+                }
+            }
+
+            auto primeMask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(prime)));
+            auto candidateMask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(candidate)));
+            for (std::size_t lane = 0; lane < 8; ++lane) {
+                primes[i + lane] = static_cast<std::uint8_t>((primeMask >> lane) & 1U);
+            }
+            for (; candidateMask != 0; candidateMask &= candidateMask - 1) {
+                auto lane = static_cast<std::size_t>(std::countr_zero(candidateMask));
+                candidates.push_back(static_cast<std::uint32_t>(values[i + lane]));
+                positions.push_back(i + lane);
+            }
+        }
+        for (; i < values.size(); ++i) {
+            primes[i] = isPrime(values[i]) ? 1 : 0;
+        }
+
+        // the last group is filled up with copies of its first candidate
+        for (std::size_t first = 0; first < candidates.size(); first += 8) {
+            std::uint32_t group[8];
+            for (std::size_t lane = 0; lane < 8; ++lane) {
+                group[lane] = first + lane < candidates.size() ? candidates[first + lane] : candidates[first];
+            }
+            unsigned passed = millerRabin8(group);
+            for (std::size_t lane = 0; lane < 8 && first + lane < candidates.size(); ++lane) {
+                primes[positions[first + lane]] = static_cast<std::uint8_t>((passed >> lane) & 1U);
+            }
+        }
+    }
+#endif
+}
+
+/*                          isPrimeBatch
+   ======================================================================
+   primes[i] = 1 when values[i] is a prime, 0 otherwise. primes has to
+   hold values.size() flags. the candidate lists of the vector path come
+   from resource.
+   time complexity: O(n) primality tests, 8 at a time with AVX2.
+   */
+template <PrimeTestable T>
+void isPrimeBatch(std::span<const T> values, std::span<std::uint8_t> primes, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+#ifdef ARIEL_PRIMALITY_AVX2
+    if constexpr (BatchPrimeTestable<T>) {
+        if (primality::hasAvx2()) {
+            primality::isPrimeBatchAvx2(values, primes, resource);
+            return;
+        }
+    }
+#endif
+    (void)resource;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        primes[i] = isPrime(values[i]) ? 1 : 0;
+    }
+}
+
+// true when isPrimeBatch tests the elements of type T 8 at a time on this machine
+template <PrimeTestable T>
+bool isPrimeBatchVectorized() {
+#ifdef ARIEL_PRIMALITY_AVX2
+    if constexpr (BatchPrimeTestable<T>) {
+        return primality::hasAvx2();
+    }
+#endif
+    return false;
+}
+
+}
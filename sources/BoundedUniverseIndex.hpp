@@ -0,0 +1,596 @@
+/*                     BoundedUniverseIndex.hpp
+   ======================================================================
+   This header file defines the BoundedUniverseIndex class, a sorted
+   index for integer elements that are known to lie in a small universe
+   [0, 2^Bits), for example 24 bit sensor readings. It can back the
+   MagicalContainer instead of the OrderStatisticTree:
+       BasicMagicalContainer<int, less<int>, 16, DoublingGrowth,
+                             BoundedUniverse<24>::Index>
+
+   Instead of comparing elements it indexes them by their bits, like a
+   van Emde Boas tree flattened into a 64-ary bit trie:
+   - level 0 has one bit per value of the universe (is it stored?),
+     packed 64 to a word.
+   - every word of level l is summarized by one bit of level l + 1 (is
+     the word non-zero?), up to a single word at the top. A 24 bit
+     universe has 4 levels.
+   So finding the successor of a value (the smallest stored value that
+   is not less than it) looks at one word per level on the way up and
+   one on the way down, with a count-trailing-zeros instruction each:
+   O(log U / log 64) word operations, no comparisons and no pointers.
+   insert and erase set / clear one bit per level, and stop climbing as
+   soon as a word was (or stays) non-zero.
+   operator++ of the iterators is such a successor query.
+
+   Every word also has the number of elements under it (counts), which
+   turns the trie into an order-statistic index: select(rank) and
+   lowerBound(value) go down / up the levels adding the counts of the
+   children on the left, at most 64 of them per level.
+   A value stored more than once keeps its bit, the extra occurrences
+   are counted in a HashIndex. A leaf word whose count is its popcount
+   has no repeated values, so the hash is only read for the words that
+   do. A handle is the value and the occurrence (low 32 bits), like in
+   the RunLengthTree.
+
+   The iterators read the elements by reference, but the trie does not
+   store the elements, only their bits. Every non-empty leaf word gets
+   a block of the 64 values it stands for, so value() can hand out a
+   reference. The blocks of leaf words that become empty are reused.
+
+   The bitmaps and the counts cover the whole universe: for 24 bits about
+   4 MB, allocated on the first insert (an empty index allocates nothing)
+   from the std::pmr::memory_resource of the index. That is what buys
+   the speed on dense data, on sparse data the comparison based indexes
+   use less memory (see the universe section of Bench.cpp).
+   Inserting a value outside the universe throws std::out_of_range. The
+   index never restructures, so it has no tombstones and the compaction
+   threshold is ignored (but still validated).
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "GrowthPolicy.hpp"
+#include "HashIndex.hpp"
+
+namespace ariel {
+
+template <typename T, typename Compare = std::less<T>, std::size_t InlineCapacity = 0, typename Growth = DoublingGrowth, unsigned Bits = 24>
+class BoundedUniverseIndex {
+    static_assert(std::is_integral_v<T>, "the universe holds integers");
+    static_assert(std::same_as<Compare, std::less<T>> || std::same_as<Compare, std::less<>>, "the universe is ordered by value");
+    static_assert(Bits >= 6 && Bits <= 30 && Bits < 8 * sizeof(T), "the universe has to fit in T and in 30 bits");
+
+    public:
+        // the value (high 32 bits) and the occurrence of the value (low 32 bits)
+        using handle = std::uint64_t;
+        static constexpr handle npos = UINT64_MAX;
+        static constexpr std::uint64_t universe = std::uint64_t{1} << Bits;
+
+    private:
+        using key = std::uint32_t;
+        static constexpr unsigned levels = (Bits + 5) / 6;
+        static constexpr std::uint32_t nil = UINT32_MAX;
+
+        // how many bits level l has: the values, then one per word below
+        static constexpr std::uint64_t items(unsigned level) {
+            std::uint64_t count = universe;
+            for (unsigned l = 0; l < level; ++l) {
+                count = (count + 63) / 64;
+            }
+            return count;
+        }
+
+        static constexpr std::uint64_t words(unsigned level) {
+            return (items(level) + 63) / 64;
+        }
+
+        std::array<std::pmr::vector<std::uint64_t>, levels> bits;
+        // the elements under every word, occurrences included
+        std::array<std::pmr::vector<std::uint32_t>, levels> counts;
+        // occurrences beyond the first of every repeated value
+        HashIndex<key> repeats;
+        // the value block of every leaf word, nil while the word is empty
+        std::pmr::vector<std::uint32_t> block_of;
+        std::pmr::vector<T> value_blocks;
+        std::pmr::vector<std::uint32_t> free_blocks;
+        std::size_t element_count = 0;
+        std::size_t modifications = 0;
+
+        static bool inUniverse(const T& value) {
+            if constexpr (std::is_signed_v<T>) {
+                if (value < 0) {
+                    return false;
+                }
+            }
+            return static_cast<std::make_unsigned_t<T>>(value) < universe;
+        }
+
+        static handle place(key value, std::uint32_t occurrence = 0) {
+            return (static_cast<handle>(value) << 32U) | occurrence;
+        }
+
+        bool allocated() const {
+            return !this->bits[0].empty();
+        }
+
+        void allocate() {
+            if (this->allocated()) {
+                return;
+            }
+            for (unsigned level = 0; level < levels; ++level) {
+                this->bits[level].assign(words(level), 0);
+                this->counts[level].assign(words(level), 0);
+            }
+            this->block_of.assign(words(0), nil);
+        }
+
+        void release() {
+            for (unsigned level = 0; level < levels; ++level) {
+                this->bits[level] = std::pmr::vector<std::uint64_t>(this->memoryResource());
+                this->counts[level] = std::pmr::vector<std::uint32_t>(this->memoryResource());
+            }
+            this->block_of = std::pmr::vector<std::uint32_t>(this->memoryResource());
+            this->value_blocks = std::pmr::vector<T>(this->memoryResource());
+            this->free_blocks = std::pmr::vector<std::uint32_t>(this->memoryResource());
+            this->repeats.clear();
+            this->repeats.shrink_to_fit();
+        }
+
+        bool present(key value) const {
+            return this->allocated() && ((this->bits[0][value >> 6U] >> (value & 63U)) & 1U) != 0;
+        }
+
+        // how many times value is stored - O(1), a hash lookup for repeated values
+        std::uint32_t occurrences(key value) const {
+            if (!this->present(value)) {
+                return 0;
+            }
+            std::size_t word = value >> 6U;
+            if (this->counts[0][word] == static_cast<std::uint32_t>(std::popcount(this->bits[0][word]))) {
+                return 1;
+            }
+            return 1 + static_cast<std::uint32_t>(this->repeats.count(value));
+        }
+
+        // the smallest stored value >= value, nil when there is none
+        std::uint32_t successor(std::uint64_t value) const {
+            if (!this->allocated()) {
+                return nil;
+            }
+            std::uint64_t item = value;
+            for (unsigned level = 0; level < levels; ++level) {
+                if (item >= items(level)) {
+                    return nil;
+                }
+                std::uint64_t mask = this->bits[level][item >> 6U] & (~std::uint64_t{0} << (item & 63U));
+                if (mask != 0) {
+                    std::uint64_t found = (item & ~std::uint64_t{63}) | static_cast<std::uint64_t>(std::countr_zero(mask));
+                    while (level-- > 0) {
+                        found = (found << 6U) | static_cast<std::uint64_t>(std::countr_zero(this->bits[level][found]));
+                    }
+                    return static_cast<std::uint32_t>(found);
+                }
+                item = (item >> 6U) + 1;
+            }
+            return nil;
+        }
+
+        // the largest stored value <= value, nil when there is none
+        std::uint32_t predecessor(std::uint64_t value) const {
+            if (!this->allocated()) {
+                return nil;
+            }
+            std::uint64_t item = value;
+            for (unsigned level = 0; level < levels; ++level) {
+                std::uint64_t mask = this->bits[level][item >> 6U] & (~std::uint64_t{0} >> (63U - (item & 63U)));
+                if (mask != 0) {
+                    std::uint64_t found = (item & ~std::uint64_t{63}) | static_cast<std::uint64_t>(63 - std::countl_zero(mask));
+                    while (level-- > 0) {
+                        found = (found << 6U) | static_cast<std::uint64_t>(63 - std::countl_zero(this->bits[level][found]));
+                    }
+                    return static_cast<std::uint32_t>(found);
+                }
+                if ((item >> 6U) == 0) {
+                    return nil;
+                }
+                item = (item >> 6U) - 1;
+            }
+            return nil;
+        }
+
+        // the block of the 64 values of a leaf word that just became non-empty
+        void attachBlock(std::size_t word) {
+            std::uint32_t block;
+            if (this->free_blocks.empty()) {
+                block = static_cast<std::uint32_t>(this->value_blocks.size() / 64);
+                this->value_blocks.resize(this->value_blocks.size() + 64);
+            } else {
+                block = this->free_blocks.back();
+                this->free_blocks.pop_back();
+            }
+            for (std::size_t i = 0; i < 64; ++i) {
+                this->value_blocks[64 * block + i] = static_cast<T>(64 * word + i);
+            }
+            this->block_of[word] = block;
+        }
+
+        void detachBlock(std::size_t word) {
+            this->free_blocks.push_back(this->block_of[word]);
+            this->block_of[word] = nil;
+        }
+
+        // elements whose value is less than value, in the leaf word of value
+        std::size_t rankInWord(key value) const {
+            std::size_t word = value >> 6U;
+            std::uint64_t below = this->bits[0][word] & ((std::uint64_t{1} << (value & 63U)) - 1);
+            if (this->counts[0][word] == static_cast<std::uint32_t>(std::popcount(this->bits[0][word]))) {
+                return static_cast<std::size_t>(std::popcount(below));
+            }
+            std::size_t rank = 0;
+            for (; below != 0; below &= below - 1) {
+                rank += this->occurrences(static_cast<key>(64 * word + static_cast<std::size_t>(std::countr_zero(below))));
+            }
+            return rank;
+        }
+
+    public:
+        explicit BoundedUniverseIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : bits(), counts(), repeats(resource), block_of(resource), value_blocks(resource), free_blocks(resource) {
+            for (unsigned level = 0; level < levels; ++level) {
+                this->bits[level] = std::pmr::vector<std::uint64_t>(resource);
+                this->counts[level] = std::pmr::vector<std::uint32_t>(resource);
+            }
+        }
+
+        BoundedUniverseIndex(const BoundedUniverseIndex&) = default;
+        BoundedUniverseIndex& operator=(const BoundedUniverseIndex&) = default;
+
+        // the moved-from index is left empty, like after clear()
+        BoundedUniverseIndex(BoundedUniverseIndex&& other) noexcept
+            : bits(std::move(other.bits)), counts(std::move(other.counts)), repeats(std::move(other.repeats)), block_of(std::move(other.block_of)),
+              value_blocks(std::move(other.value_blocks)), free_blocks(std::move(other.free_blocks)), element_count(other.element_count), modifications(other.modifications) {
+            other.clear();
+        }
+
+        // the version moves past both old ones, so no cached handle survives
+        BoundedUniverseIndex& operator=(BoundedUniverseIndex&& other) {
+            if (this != &other) {
+                std::size_t version = std::max(this->modifications, other.modifications) + 1;
+                this->bits = std::move(other.bits);
+                this->counts = std::move(other.counts);
+                this->repeats = std::move(other.repeats);
+                this->block_of = std::move(other.block_of);
+                this->value_blocks = std::move(other.value_blocks);
+                this->free_blocks = std::move(other.free_blocks);
+                this->element_count = other.element_count;
+                this->modifications = version;
+                other.clear();
+            }
+            return *this;
+        }
+
+        std::pmr::memory_resource* memoryResource() const {
+            return this->block_of.get_allocator().resource();
+        }
+
+        std::size_t size() const {
+            return this->element_count;
+        }
+
+        bool empty() const {
+            return this->element_count == 0;
+        }
+
+        // nothing has to grow before the universe is full
+        std::size_t capacity() const {
+            return std::numeric_limits<std::size_t>::max();
+        }
+
+        // allocates the bitmaps up front, so the first insert does not
+        void reserve(std::size_t capacity) {
+            if (capacity != 0) {
+                this->allocate();
+            }
+        }
+
+        // an empty index gives its bitmaps back
+        void shrink_to_fit() {
+            if (this->element_count == 0) {
+                this->release();
+            }
+            this->repeats.shrink_to_fit();
+        }
+
+        std::size_t tombstones() const {
+            return 0;
+        }
+
+        // validated like the other indexes, there is nothing to compact
+        void setCompactionThreshold(double ratio) {
+            if (!(ratio >= 0.0 && ratio <= 1.0)) {
+                throw std::invalid_argument("compaction threshold must be between 0 and 1");
+            }
+        }
+
+        std::size_t version() const {
+            return this->modifications;
+        }
+
+        /* insert
+           one more occurrence of value. a new value sets its bit on every
+           level up to the first word that was already non-zero.
+           throws std::out_of_range when value is outside the universe.
+           time complexity: O(log U / log 64).
+        */
+        void insert(const T& value) {
+            if (!inUniverse(value)) {
+                throw std::out_of_range("error at : BoundedUniverseIndex::insert , The error: value outside the universe.");
+            }
+            this->allocate();
+            auto current = static_cast<key>(value);
+            if (this->present(current)) {
+                this->repeats.add(current);
+            } else {
+                if (this->bits[0][current >> 6U] == 0) {
+                    this->attachBlock(current >> 6U);
+                }
+                std::uint64_t item = current;
+                for (unsigned level = 0; level < levels; ++level) {
+                    std::uint64_t& word = this->bits[level][item >> 6U];
+                    bool wasEmpty = word == 0;
+                    word |= std::uint64_t{1} << (item & 63U);
+                    if (!wasEmpty) {
+                        break;
+                    }
+                    item >>= 6U;
+                }
+            }
+            std::uint64_t item = current;
+            for (unsigned level = 0; level < levels; ++level) {
+                ++this->counts[level][item >> 6U];
+                item >>= 6U;
+            }
+            ++this->element_count;
+            ++this->modifications;
+        }
+
+        // inserts an ascending batch, all of it or nothing: the ends are
+        // checked first - O(k log U / log 64)
+        void insertSorted(std::span<const T> sorted) {
+            if (!sorted.empty() && (!inUniverse(sorted.front()) || !inUniverse(sorted.back()))) {
+                throw std::out_of_range("error at : BoundedUniverseIndex::insertSorted , The error: value outside the universe.");
+            }
+            for (const T& value : sorted) {
+                this->insert(value);
+            }
+        }
+
+        /* erase
+           removes one occurrence of value, the last one clears its bit on
+           every level up to the first word that stays non-zero.
+           returns false when value is not stored.
+           time complexity: O(log U / log 64).
+        */
+        bool erase(const T& value) {
+            if (!inUniverse(value) || !this->present(static_cast<key>(value))) {
+                return false;
+            }
+            auto current = static_cast<key>(value);
+            if (!this->repeats.remove(current)) {
+                std::uint64_t item = current;
+                for (unsigned level = 0; level < levels; ++level) {
+                    std::uint64_t& word = this->bits[level][item >> 6U];
+                    word &= ~(std::uint64_t{1} << (item & 63U));
+                    if (word != 0) {
+                        break;
+                    }
+                    if (level == 0) {
+                        this->detachBlock(item >> 6U);
+                    }
+                    item >>= 6U;
+                }
+            }
+            std::uint64_t item = current;
+            for (unsigned level = 0; level < levels; ++level) {
+                --this->counts[level][item >> 6U];
+                item >>= 6U;
+            }
+            --this->element_count;
+            ++this->modifications;
+            return true;
+        }
+
+        // one erase per value of an ascending batch - O(k log U / log 64)
+        std::size_t eraseSorted(std::span<const T> sorted) {
+            std::size_t removed = 0;
+            for (const T& value : sorted) {
+                if (this->erase(value)) {
+                    ++removed;
+                }
+            }
+            return removed;
+        }
+
+        /* extractIf
+           removes every element for which predicate returns true and
+           returns them in ascending order. predicate is called once per
+           distinct value, all the occurrences of a value go together.
+           time complexity: O(n log U / log 64).
+        */
+        template <typename Predicate>
+        std::pmr::vector<T> extractIf(Predicate predicate) {
+            std::pmr::vector<T> removed(this->memoryResource());
+            for (std::uint32_t value = this->successor(0); value != nil; value = this->successor(std::uint64_t{value} + 1)) {
+                if (predicate(static_cast<T>(value))) {
+                    removed.insert(removed.end(), this->occurrences(value), static_cast<T>(value));
+                }
+            }
+            for (const T& value : removed) {
+                this->erase(value);
+            }
+            return removed;
+        }
+
+        void clear() {
+            this->release();
+            this->element_count = 0;
+            ++this->modifications;
+        }
+
+        /* select
+           the handle of the rank-th smallest element (0 based), npos when
+           rank is out of range: from the top word down, skipping the
+           children on the left by their counts.
+           time complexity: O(64 log U / log 64).
+        */
+        handle select(std::size_t rank) const {
+            if (rank >= this->element_count) {
+                return npos;
+            }
+            std::size_t word = 0;
+            for (unsigned level = levels - 1; level > 0; --level) {
+                for (std::uint64_t mask = this->bits[level][word]; mask != 0; mask &= mask - 1) {
+                    std::size_t child = 64 * word + static_cast<std::size_t>(std::countr_zero(mask));
+                    if (rank < this->counts[level - 1][child]) {
+                        word = child;
+                        break;
+                    }
+                    rank -= this->counts[level - 1][child];
+                }
+            }
+            for (std::uint64_t mask = this->bits[0][word]; mask != 0; mask &= mask - 1) {
+                auto value = static_cast<key>(64 * word + static_cast<std::size_t>(std::countr_zero(mask)));
+                std::uint32_t count = this->occurrences(value);
+                if (rank < count) {
+                    return place(value, static_cast<std::uint32_t>(rank));
+                }
+                rank -= count;
+            }
+            return npos;
+        }
+
+        // number of elements less than value - O(64 log U / log 64)
+        std::size_t lowerBound(const T& value) const {
+            if constexpr (std::is_signed_v<T>) {
+                if (value < 0) {
+                    return 0;
+                }
+            }
+            if (!inUniverse(value)) {
+                return this->element_count;
+            }
+            if (!this->allocated()) {
+                return 0;
+            }
+            auto current = static_cast<key>(value);
+            std::size_t rank = this->rankInWord(current);
+            std::uint64_t item = current >> 6U;
+            for (unsigned level = 1; level < levels; ++level) {
+                std::uint64_t below = this->bits[level][item >> 6U] & ((std::uint64_t{1} << (item & 63U)) - 1);
+                for (; below != 0; below &= below - 1) {
+                    rank += this->counts[level - 1][(item & ~std::uint64_t{63}) | static_cast<std::uint64_t>(std::countr_zero(below))];
+                }
+                item >>= 6U;
+            }
+            return rank;
+        }
+
+        // number of elements not greater than value - O(64 log U / log 64)
+        std::size_t upperBound(const T& value) const {
+            if (!inUniverse(value)) {
+                return this->lowerBound(value);
+            }
+            if (static_cast<std::uint64_t>(value) + 1 == universe) {
+                return this->element_count;
+            }
+            return this->lowerBound(static_cast<T>(value + 1));
+        }
+
+        // walking the elements in order, one successor query per new value
+        handle front() const {
+            std::uint32_t first = this->successor(0);
+            return first == nil ? npos : place(first);
+        }
+
+        handle back() const {
+            std::uint32_t last = this->predecessor(universe - 1);
+            return last == nil ? npos : place(last, this->occurrences(last) - 1);
+        }
+
+        handle next(handle position) const {
+            if (position == npos) {
+                return npos;
+            }
+            auto value = static_cast<key>(position >> 32U);
+            if (static_cast<std::uint32_t>(position) + 1 < this->occurrences(value)) {
+                return position + 1;
+            }
+            std::uint32_t following = this->successor(std::uint64_t{value} + 1);
+            return following == nil ? npos : place(following);
+        }
+
+        handle prev(handle position) const {
+            if (position == npos) {
+                return npos;
+            }
+            if (static_cast<std::uint32_t>(position) != 0) {
+                return position - 1;
+            }
+            auto value = static_cast<key>(position >> 32U);
+            std::uint32_t preceding = value == 0 ? nil : this->predecessor(value - 1);
+            return preceding == nil ? npos : place(preceding, this->occurrences(preceding) - 1);
+        }
+
+        const T& value(handle position) const {
+            auto current = static_cast<key>(position >> 32U);
+            return this->value_blocks[64 * std::size_t{this->block_of[current >> 6U]} + (current & 63U)];
+        }
+
+        /* gather
+           copies the elements from position on into out, as many as fit,
+           and returns the position after the last one copied (npos at the
+           end). the values of a leaf word are read off its bits.
+           time complexity: O(k + log U / log 64 per leaf word).
+        */
+        handle gather(handle position, std::span<T> out) const {
+            std::size_t copied = 0;
+            while (position != npos && copied < out.size()) {
+                auto current = static_cast<key>(position >> 32U);
+                auto occurrence = static_cast<std::uint32_t>(position);
+                std::uint32_t count = this->occurrences(current);
+                std::size_t run = std::min<std::size_t>(count - occurrence, out.size() - copied);
+                std::fill_n(out.data() + copied, run, static_cast<T>(current));
+                copied += run;
+                if (occurrence + run < count) {
+                    return position + run;
+                }
+                position = this->next(place(current, count - 1));
+            }
+            return position;
+        }
+};
+
+// picks the universe: BoundedUniverse<24>::Index is the SortedIndex of a
+// container of values in [0, 2^24)
+template <unsigned Bits>
+struct BoundedUniverse {
+    template <typename T, typename Compare, std::size_t InlineCapacity, typename Growth>
+    using Index = BoundedUniverseIndex<T, Compare, InlineCapacity, Growth, Bits>;
+};
+
+}
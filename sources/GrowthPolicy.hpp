@@ -0,0 +1,51 @@
+/*                        GrowthPolicy.hpp
+   ======================================================================
+   This header file defines the growth policies of the SmallVector, the
+   rule that decides how big the next buffer is when a full array needs
+   room for one more element.
+
+   A growth policy is a type with one static function:
+       static std::size_t grow(std::size_t capacity);
+   which returns the new capacity (always more than capacity).
+
+   - GeometricGrowth<Numerator, Denominator>: multiplies the capacity by
+     Numerator / Denominator. Appending stays O(1) amortized, a bigger
+     factor reallocates less often and wastes more memory.
+     - DoublingGrowth (2x) is the default, the fewest reallocations.
+     - HalfAgainGrowth (1.5x) leaves at most a third of the buffer unused.
+   - ChunkGrowth<Chunk>: adds Chunk elements every time. The waste is at
+     most Chunk elements, but appending n elements costs O(n^2 / Chunk)
+     copies, so it suits containers whose size is known up front
+     (reserve) or stays within a few chunks.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace ariel {
+
+template <std::size_t Numerator, std::size_t Denominator = 1>
+struct GeometricGrowth {
+    static_assert(Denominator != 0 && Numerator > Denominator, "the growth factor must be more than 1");
+
+    static constexpr std::size_t grow(std::size_t capacity) {
+        return std::max(capacity + 1, capacity * Numerator / Denominator);
+    }
+};
+
+using DoublingGrowth = GeometricGrowth<2>;
+using HalfAgainGrowth = GeometricGrowth<3, 2>;
+
+template <std::size_t Chunk>
+struct ChunkGrowth {
+    static_assert(Chunk != 0, "the chunk must hold at least one element");
+
+    static constexpr std::size_t grow(std::size_t capacity) {
+        return capacity + Chunk;
+    }
+};
+
+}
@@ -0,0 +1,246 @@
+/*                        HashIndex.hpp
+   ======================================================================
+   This header file defines the HashIndex class, a hash table that
+   counts how many times every value is stored in the MagicalContainer.
+
+   The container asks it whether a value exists before touching the
+   trees, so looking up an element (and finding out that it is missing)
+   costs O(1) expected instead of a search.
+   Duplicates are handled by counting: a value that was added three
+   times has one slot with count 3.
+
+   The table uses open addressing with linear probing: all the slots
+   live in one vector and a collision moves on to the next slot, so a
+   lookup usually reads one or two neighbouring slots.
+   - The hash of the value is scrambled with a multiplication by the
+     golden ratio (Fibonacci hashing), std::hash<int> is the identity and
+     would put values like 1024, 2048, 3072 in one long cluster.
+   - The table is kept at most half full and doubles when it gets there
+     (the probing needs a power of two number of slots, so the growth
+     policy of the container does not apply here). reserve() sizes it
+     for a known number of keys up front, shrink_to_fit() shrinks it to
+     the smallest table that holds the keys it has.
+   - The slots for the first InlineKeys distinct values are a SmallVector
+     buffer inside the object, a small index never allocates. A bigger
+     table comes from the std::pmr::memory_resource of the index.
+   - Removing a key shifts the following keys of its cluster back
+     (backward shift deletion), so there are no tombstone slots and a
+     miss stops at the first empty slot.
+   - Every slot has one more bit next to its count, a mark that is
+     computed once when the value arrives (add with a classifier) and
+     handed back by every later add and remove of the value. The
+     container marks the primes, so a value is tested for primality once
+     however many times it is added and removed. The mark takes the top
+     bit of the count, a slot is still 8 bytes for int keys and a value
+     can be stored up to 2^31 - 1 times.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <memory_resource>
+#include <utility>
+#include "SmallVector.hpp"
+
+namespace ariel {
+
+template <typename T, typename Hash = std::hash<T>, std::size_t InlineKeys = 0>
+class HashIndex {
+    private:
+        struct Slot {
+            T key;
+            std::uint32_t count : 31;  // 0 = empty slot
+            std::uint32_t marked : 1;
+        };
+
+        // InlineKeys keys keep the table at most half full
+        static constexpr std::size_t inline_slots = InlineKeys == 0 ? 0 : std::max<std::size_t>(16, std::bit_ceil(2 * InlineKeys));
+        static constexpr std::size_t min_capacity = std::max<std::size_t>(16, inline_slots);
+
+        SmallVector<Slot, inline_slots> slots;
+        std::size_t used = 0;
+        unsigned shift = 64;
+        Hash hasher;
+
+        std::size_t home(const T& key) const {
+            std::uint64_t hash = static_cast<std::uint64_t>(this->hasher(key));
+            return static_cast<std::size_t>((hash * 0x9E3779B97F4A7C15ULL) >> this->shift);
+        }
+
+        std::size_t mask() const {
+            return this->slots.size() - 1;
+        }
+
+        // the slot of key, or the empty slot where it would go
+        std::size_t probe(const T& key) const {
+            std::size_t slot = this->home(key);
+            while (this->slots[slot].count != 0 && !(this->slots[slot].key == key)) {
+                slot = (slot + 1) & this->mask();
+            }
+            return slot;
+        }
+
+        void rehash(std::size_t capacity) {
+            SmallVector<Slot, inline_slots> old(std::move(this->slots));
+            this->slots.assign(capacity, Slot{T(), 0, 0});
+            this->shift = 64;
+            for (std::size_t bits = capacity; bits > 1; bits >>= 1U) {
+                --this->shift;
+            }
+            for (const Slot& entry : old) {
+                if (entry.count != 0) {
+                    this->slots[this->probe(entry.key)] = entry;
+                }
+            }
+        }
+
+    public:
+        explicit HashIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : slots(resource) {
+            if constexpr (inline_slots != 0) {
+                this->rehash(inline_slots);
+            }
+        }
+
+        HashIndex(const HashIndex&) = default;
+        HashIndex& operator=(const HashIndex&) = default;
+
+        // the moved-from index is left empty, like after clear()
+        HashIndex(HashIndex&& other) noexcept
+            : slots(std::move(other.slots)), used(other.used), shift(other.shift), hasher(other.hasher) {
+            other.clear();
+        }
+
+        HashIndex& operator=(HashIndex&& other) {
+            if (this != &other) {
+                this->slots = std::move(other.slots);
+                this->used = other.used;
+                this->shift = other.shift;
+                this->hasher = other.hasher;
+                other.clear();
+            }
+            return *this;
+        }
+
+        // number of distinct values
+        std::size_t size() const {
+            return this->used;
+        }
+
+        /* count
+           how many times value was added (and not removed yet).
+           time complexity: O(1) expected.
+        */
+        std::size_t count(const T& value) const {
+            if (this->slots.empty()) {
+                return 0;
+            }
+            return this->slots[this->probe(value)].count;
+        }
+
+        /* add
+           counts one more occurrence of value. the first occurrence of a 
+           value is marked with classify(value), the later ones keep that 
+           mark without calling classify. returns the mark of value.
+           time complexity: O(1) amortized expected, plus one call of 
+           classify for a new value.
+        */
+        template <typename Classify>
+        bool add(const T& value, Classify classify) {
+            if (2 * (this->used + 1) > this->slots.size()) {
+                this->rehash(this->slots.empty() ? min_capacity : 2 * this->slots.size());
+            }
+            Slot& slot = this->slots[this->probe(value)];
+            if (slot.count == 0) {
+                slot.key = value;
+                slot.marked = classify(value) ? 1U : 0U;
+                ++this->used;
+            }
+            ++slot.count;
+            return slot.marked != 0;
+        }
+
+        void add(const T& value) {
+            this->add(value, [](const T&) { return false; });
+        }
+
+        /* remove
+           forgets one occurrence of value, returns false when there is none.
+           marked is set to the mark of value when it was there.
+           time complexity: O(1) expected.
+        */
+        bool remove(const T& value, bool& marked) {
+            if (this->slots.empty()) {
+                return false;
+            }
+            std::size_t hole = this->probe(value);
+            if (this->slots[hole].count == 0) {
+                return false;
+            }
+            marked = this->slots[hole].marked != 0;
+            if (--this->slots[hole].count != 0) {
+                return true;
+            }
+            --this->used;
+            // backward shift: pull back every key of the cluster that may
+            // not stay behind the hole
+            for (std::size_t next = (hole + 1) & this->mask(); this->slots[next].count != 0; next = (next + 1) & this->mask()) {
+                std::size_t wanted = this->home(this->slots[next].key);
+                std::size_t distanceToHole = (hole - wanted) & this->mask();
+                std::size_t distanceToNext = (next - wanted) & this->mask();
+                if (distanceToHole < distanceToNext) {
+                    this->slots[hole] = this->slots[next];
+                    this->slots[next].count = 0;
+                    hole = next;
+                }
+            }
+            return true;
+        }
+
+        bool remove(const T& value) {
+            bool marked = false;
+            return this->remove(value, marked);
+        }
+
+        // how many distinct values fit before the table grows
+        std::size_t capacity() const {
+            return this->slots.size() / 2;
+        }
+
+        /* reserve
+           grows the table so that keys distinct values fit without a rehash.
+           time complexity: O(capacity) when the table grows, O(1) otherwise.
+        */
+        void reserve(std::size_t keys) {
+            if (2 * keys > this->slots.size()) {
+                this->rehash(std::max(min_capacity, std::bit_ceil(2 * keys)));
+            }
+        }
+
+        /* shrink_to_fit
+           rehashes into the smallest table that keeps the keys at most half
+           full (but not smaller than the inline one).
+           time complexity: O(capacity).
+        */
+        void shrink_to_fit() {
+            std::size_t fitting = std::max(min_capacity, std::bit_ceil(2 * this->used));
+            if (!this->slots.empty() && fitting < this->slots.size()) {
+                this->rehash(fitting);
+            }
+        }
+
+        void clear() {
+            this->slots.clear();
+            this->used = 0;
+            this->shift = 64;
+            if constexpr (inline_slots != 0) {
+                this->rehash(inline_slots);
+            }
+        }
+};
+
+}
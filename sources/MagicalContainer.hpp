@@ -3,13 +3,27 @@
    This header file defines the MagicalContainer class, which represents 
    a container for storing integers in a magical way.
 
+   MagicalContainer is BasicMagicalContainer<int>. The container is a 
+   template over the element type T (and its ordering, Compare), so 
+   int64_t or uint32_t elements can be stored as they are. The 
+   PrimeIterator exists for the integral types only, every width gets 
+   its own primality test (see Primality.hpp).
+
    The MagicalContainer class provides the following functionality:
    - Adding elements: The addElement() function allows adding an integer 
      element to the container.
+   - Adding many elements: addElements() adds a whole batch (a span or 
+     an iterator range) in one go, the result is the same as adding the 
+     elements one by one.
    - Removing elements: The removeElement() function allows removing a 
      specified integer element from the container.
+   - Removing many elements: removeElements() removes one occurrence of 
+     every element of a batch and removeIf() removes all the elements 
+     that match a predicate, both in one pass over the container, and 
+     return how many elements were removed.
    - Size retrieval: The size() function returns the current size of the 
-     container.
+     container, and primeCount() how many of its elements are primes, 
+     both in O(1).
 
    Iterators:
    The MagicalContainer class also provides three iterator classes for 
@@ -19,6 +33,15 @@
       cross pattern.
    3. PrimeIterator: Iterates over the prime number elements in the 
       container.
+   4. DescendingIterator: Iterates over the elements from the largest 
+      to the smallest, walking the ascending tree backwards (no second 
+      index, O(1) per step). It is bidirectional (operator--).
+   5. MergedAscendingIterator: Iterates over the elements of N containers 
+      (shards of one data set) as one ascending stream. Nothing is 
+      copied: every container keeps its own position, and a loser tree 
+      over the N current elements picks the smallest, O(log N) 
+      comparisons per step. Equal elements come out in the order of 
+      their containers.
 
    Each iterator class supports the following operations:
    - Default constructor: Constructs an iterator object.
@@ -29,46 +52,231 @@
      another.
    - Greater-than (>) and less-than (<) comparison operators: Compare the 
      iterators based on their location in the container.
+   The AscendingIterator is also a std::random_access_iterator: it can 
+   step back (--), jump (+=, -=, +, -), read at an offset ([]) and 
+   measure the distance to another iterator (it2 - it1), all in O(1) or 
+   O(log n) through the ranks of the tree. So std::lower_bound, 
+   std::distance or a percentile lookup work on the ascending view 
+   directly. seek_lower(value) / seek_upper(value) move it to the first 
+   element that is not less / greater than value in O(log n), and 
+   equal_range(value) of the container returns the two of them.
+   The PrimeIterator has the same random access operators over the 
+   ranks of the prime tree, so the k-th prime of the container is 
+   primes.begin()[k]. It stays attached to its container (a reference), 
+   so it is not default constructible like the AscendingIterator.
+   Bounded views: AscendingIterator(container, lo, hi) and 
+   PrimeIterator(container, lo, hi) only cover the elements in the value 
+   window [lo, hi). Their begin() and end() are found by binary search on 
+   the sorted index when they are called, so going over the k elements of 
+   the window costs O(log n + k), and elements that are added inside the 
+   window later are seen too. Every step, jump and dereference stays 
+   inside the window and throws like the unbounded iterators do at their 
+   ends, and a seek stops at begin() or end() of the window (the ranks of 
+   lo and hi are kept until the container changes).
+
+   Internal storage:
+   The elements are kept in an OrderStatisticTree (a treap that knows the 
+   size of every subtree), and the prime elements are kept in a second 
+   one. Adding or removing an element costs O(log n), and every iterator 
+   position maps to a rank in one of the trees.
+   The iterators remember the node of their current position, so stepping 
+   forward is O(1) as long as the container was not modified. After a 
+   modification the node is looked up again by rank in O(log n), which 
+   keeps the iterators attached to the container.
+   Removing an element leaves a tombstone in the trees instead of 
+   restructuring them, and a tree is rebuilt without its tombstones once 
+   they pass the compaction threshold (setCompactionThreshold). The 
+   iterator positions count live elements only, so neither the 
+   tombstones nor the rebuilds are visible through the iterators.
+   A HashIndex counts the occurrences of every value, so removeElement 
+   finds out in O(1) whether the element exists before touching the trees.
+   It also keeps one bit per value saying whether the value is a prime, 
+   so primality is tested once per distinct value: adding the value again 
+   or removing it reads the bit instead.
+   Values below 2^20 are classified by one probe of a table sieved at 
+   compile time (see Primality.hpp), and addElements classifies a big 
+   batch of dense values with one segmented sieve over its range (see 
+   PrimeSieve.hpp), or any other batch of 32 bit values 8 at a time with 
+   AVX2 when the processor has it (see BatchPrimality.hpp).
+   The trees and the hash index keep their first InlineCapacity elements 
+   inside the container object (see SmallVector.hpp), so creating, 
+   filling and iterating a container of up to InlineCapacity elements 
+   does not allocate anything on the heap.
+   Everything the container allocates beyond that - the tree nodes, the 
+   hash table and the temporary arrays of the batch operations - comes 
+   from the std::pmr::memory_resource given to the constructor, so a 
+   whole request can be served from one arena (for example a 
+   std::pmr::monotonic_buffer_resource) and freed in one step.
+
+   Capacity:
+   reserve(n) makes room for n elements in the ascending tree and the 
+   hash index at once, so a container whose size is known up front fills 
+   without a single reallocation. capacity() is how many elements fit 
+   before something has to grow, and shrink_to_fit() drops the 
+   tombstones and gives back the unused memory of every internal array.
+   How much an array grows when it is full is the Growth policy, the 
+   fourth template parameter (see GrowthPolicy.hpp): DoublingGrowth (the 
+   default, fewest reallocations), HalfAgainGrowth (1.5x, less unused 
+   memory) or ChunkGrowth<n> (n elements at a time, the least memory).
+
+   Sorted index:
+   The last template parameter picks the class that keeps the elements 
+   sorted, they all have the same interface:
+   - OrderStatisticTree (the default): a treap, O(log n) to add or 
+     remove an element.
+   - RunLengthTree: the same treap in multiset mode, one node per 
+     distinct value holding a (value, count) run. Adding or removing an 
+     occurrence of a value that is already there changes the counts in 
+     O(log n), and the memory grows with the number of distinct values 
+     instead of the number of elements - for data that repeats a few 
+     values a lot. The iterators still visit every occurrence.
+   - PackedMemoryArray: one sorted array with gaps, O(log^2 n) amortized 
+     to add or remove an element, but stepping an iterator forward is a 
+     sequential scan of one array. It suits containers that are iterated 
+     much more than they are modified (see Bench.cpp, make bench).
+   - BoundedUniverse<Bits>::Index: for integers known to lie in 
+     [0, 2^Bits), a 64-ary bit trie (van Emde Boas style) over the whole 
+     universe. Adding, removing and the successor query behind 
+     operator++ cost O(log U / log 64) word operations, 4 for 24 bits, 
+     without comparing elements. Adding an element outside the universe 
+     throws std::out_of_range and leaves the container unchanged.
+
+   The member definitions are in MagicalContainerImpl.hpp, and 
+   MagicalContainer.cpp instantiates MagicalContainer once for everybody.
    ======================================================================
 */
 
 #pragma once
 
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
+#include "GrowthPolicy.hpp"
+#include "OrderStatisticTree.hpp"
+#include "PackedMemoryArray.hpp"
+#include "BoundedUniverseIndex.hpp"
+#include "HashIndex.hpp"
+#include "Primality.hpp"
+#include "PrimeSieve.hpp"
+#include "BatchPrimality.hpp"
+#include "RadixSort.hpp"
 
 using namespace std;
 
 namespace ariel {
 
-class MagicalContainer {
+template <typename T, typename Compare = less<T>, size_t InlineCapacity = 16, typename Growth = DoublingGrowth,
+          template <typename, typename, size_t, typename> class SortedIndex = OrderStatisticTree>
+class BasicMagicalContainer {
     private:
-        vector<int> elements;
-        vector<int*> ascending_elements;
-        vector<int*> sidecross_elements;
-        vector<int*> prime_elements;
+        using Index = SortedIndex<T, Compare, InlineCapacity, Growth>;
+        using handle = typename Index::handle;
+
+        // only integral elements can be primes, the others skip the prime tree
+        static constexpr bool tracks_primes = PrimeTestable<T>;
+
+        Index ascending_elements;
+        Index prime_elements;
+        // how many times every value is stored, for O(1) lookups
+        HashIndex<T, hash<T>, InlineCapacity> element_counts;
+
+        static bool isPrimeElement(const T& element);
+
+        void sortBatch(pmr::vector<T>& batch) const;
+
+        void forgetRemoved(const pmr::vector<T>& removed);
 
     public:
-        MagicalContainer();
-        void addElement(int element);
+        using value_type = T;
+
+        explicit BasicMagicalContainer(pmr::memory_resource* resource = pmr::get_default_resource());
 
-        void removeElement(int element);
+        pmr::memory_resource* memoryResource() const;
+        void addElement(const T& element);
+
+        void addElements(span<const T> elements);
+
+        template <typename InputIt>
+        void addElements(InputIt first, InputIt last) {
+            if constexpr (contiguous_iterator<InputIt> && same_as<iter_value_t<InputIt>, T>) {
+                this->addElements(span<const T>(to_address(first), static_cast<size_t>(last - first)));
+            } else {
+                pmr::vector<T> batch(first, last, this->memoryResource());
+                this->addElements(span<const T>(batch));
+            }
+        }
+
+        void removeElement(const T& element);
+
+        // strict - throw (and remove nothing) when an element is missing
+        size_t removeElements(span<const T> elements, bool strict = false);
+
+        template <typename Predicate>
+        size_t removeIf(Predicate predicate) {
+            pmr::vector<T> removed = this->ascending_elements.extractIf(predicate);
+            this->forgetRemoved(removed);
+            return removed.size();
+        }
 
         int size() const;
 
-        void updateAscendingElements();
-        void updateSideCrossElements();
-        void updatePrimeElements();
+        // how many of the elements are primes - O(1), the size of the prime tree
+        int primeCount() const;
+
+        // room for n elements without growing the internal arrays
+        void reserve(size_t n);
+
+        size_t capacity() const;
+
+        void shrink_to_fit();
+
+        // rebuild a tree once more than ratio of its nodes are removed ones
+        void setCompactionThreshold(double ratio);
 
         // AscendingIterator
         class AscendingIterator {
         
         private:
-          MagicalContainer &container_ptr;  
+          // a pointer and not a reference, so the iterator can be default 
+          // constructed and assigned like any random access iterator
+          BasicMagicalContainer *container_ptr;  
           size_t index;    
+          // node of the current position, valid while cached_version matches
+          mutable handle cached_node;
+          mutable size_t cached_version;
+          // [lo, hi) of a bounded view, the iterator stays inside it
+          optional<pair<T, T>> window;
+          // the ranks of lo and hi, valid while window_version matches
+          mutable pair<size_t, size_t> window_ranks;
+          mutable size_t window_version = SIZE_MAX;
+
+          handle node() const;
+
+          // the ranks of begin() and end()
+          pair<size_t, size_t> bounds() const;
+
+          void checkSameContainer(const AscendingIterator& other, const char* where) const;
 
         public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            // default constructor - an iterator of no container
+            AscendingIterator();
             // constructor
-            AscendingIterator(MagicalContainer& container);
+            AscendingIterator(BasicMagicalContainer& container);
+            // a view of the elements in [lo, hi) only, starting at its first one
+            AscendingIterator(BasicMagicalContainer& container, const T& lo, const T& hi);
             
             // copy constructor
             AscendingIterator(const AscendingIterator& other);
@@ -81,31 +289,123 @@ class MagicalContainer {
             // inequality comparison
             bool operator!=(const AscendingIterator& other) const;
             // dereference operator
-            int& operator*() const;
+            const T& operator*() const;
+            const T* operator->() const;
             // GT
             bool operator>(const AscendingIterator& other) const;
             // LT
             bool operator<(const AscendingIterator& other) const;
+            bool operator>=(const AscendingIterator& other) const;
+            bool operator<=(const AscendingIterator& other) const;
             // pre increment
             AscendingIterator& operator++();
+            AscendingIterator operator++(int);
+            // pre decrement
+            AscendingIterator& operator--();
+            AscendingIterator operator--(int);
+
+            // random access by rank
+            AscendingIterator& operator+=(difference_type steps);
+            AscendingIterator& operator-=(difference_type steps);
+            AscendingIterator operator+(difference_type steps) const;
+            AscendingIterator operator-(difference_type steps) const;
+            difference_type operator-(const AscendingIterator& other) const;
+            const T& operator[](difference_type steps) const;
+
+            friend AscendingIterator operator+(difference_type steps, const AscendingIterator& iterator) {
+                return iterator + steps;
+            }
+
+            // moves to the first element that is not less / greater than value
+            AscendingIterator& seek_lower(const T& value);
+            AscendingIterator& seek_upper(const T& value);
+
+            // copies up to out.size() elements into out and moves past them,
+            // returns how many were copied (0 at the end)
+            size_t next_batch(span<T> out);
 
             AscendingIterator begin();
 
             AscendingIterator end();
 
-            // to keep tidy satisfied
             AscendingIterator(AscendingIterator&&) = default;
-            AscendingIterator& operator=(AscendingIterator&&) = delete;
+            AscendingIterator& operator=(AscendingIterator&& other);
+        };
+
+        // DescendingIterator
+        class DescendingIterator {
+        
+        private:
+          BasicMagicalContainer *container_ptr;  
+          // position from the largest element, the rank is size - 1 - index
+          size_t index;    
+          // node of the current position, valid while cached_version matches
+          mutable handle cached_node;
+          mutable size_t cached_version;
+
+          handle node() const;
+
+          void checkSameContainer(const DescendingIterator& other, const char* where) const;
+
+        public:
+            using iterator_concept = std::bidirectional_iterator_tag;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            // default constructor - an iterator of no container
+            DescendingIterator();
+            // constructor
+            DescendingIterator(BasicMagicalContainer& container);
+            // copy constructor
+            DescendingIterator(const DescendingIterator& other);
+            // destructor
+            ~DescendingIterator();
+            // assignment operator
+            DescendingIterator& operator=(const DescendingIterator& other);
+            // equality comparison
+            bool operator==(const DescendingIterator& other) const;
+            // inequality comparison
+            bool operator!=(const DescendingIterator& other) const;
+            // dereference operator
+            const T& operator*() const;
+            const T* operator->() const;
+            // GT
+            bool operator>(const DescendingIterator& other) const;
+            // LT
+            bool operator<(const DescendingIterator& other) const;
+            // pre increment - to the next smaller element
+            DescendingIterator& operator++();
+            DescendingIterator operator++(int);
+            // pre decrement - back to the next larger element
+            DescendingIterator& operator--();
+            DescendingIterator operator--(int);
+
+            DescendingIterator begin();
+
+            DescendingIterator end();
+
+            DescendingIterator(DescendingIterator&&) = default;
+            DescendingIterator& operator=(DescendingIterator&& other);
         };
 
         // SideCrossIterator
         class SideCrossIterator {
         private:
-            MagicalContainer &container_ptr;  
+            BasicMagicalContainer &container_ptr;  
             size_t index;
+            // nodes of the next element from the front and from the back,
+            // valid while cached_version matches
+            mutable handle cached_front;
+            mutable handle cached_back;
+            mutable size_t cached_version;
+
+            void refresh() const;
         public:
             // constructor
-            SideCrossIterator(MagicalContainer& container);
+            SideCrossIterator(BasicMagicalContainer& container);
             
             // copy constructor
             SideCrossIterator(const SideCrossIterator& other);
@@ -118,7 +418,7 @@ class MagicalContainer {
             // inequality comparison
             bool operator!=(const SideCrossIterator& other) const;
             // dereference operator
-            int& operator*() const;
+            const T& operator*() const;
             // GT
             bool operator>(const SideCrossIterator& other) const;
             // LT
@@ -126,6 +426,9 @@ class MagicalContainer {
             // pre increment
             SideCrossIterator& operator++();
 
+            // copies up to out.size() elements into out and moves past them
+            size_t next_batch(span<T> out);
+
             SideCrossIterator begin();
 
             SideCrossIterator end();
@@ -138,11 +441,33 @@ class MagicalContainer {
         // PrimeIterator
         class PrimeIterator {
         private:
-            MagicalContainer &container_ptr;  
+            BasicMagicalContainer &container_ptr;  
             size_t index;
+            // node of the current position, valid while cached_version matches
+            mutable handle cached_node;
+            mutable size_t cached_version;
+            // [lo, hi) of a bounded view, the iterator stays inside it
+            optional<pair<T, T>> window;
+            // the ranks of lo and hi, valid while window_version matches
+            mutable pair<size_t, size_t> window_ranks;
+            mutable size_t window_version = SIZE_MAX;
+
+            handle node() const;
+
+            // the ranks of begin() and end() among the primes
+            pair<size_t, size_t> bounds() const;
         public: 
-            // constructor
-            PrimeIterator(MagicalContainer& container);
+            // random access, but not default constructible (the container is a reference)
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            // constructor - only for containers of integers
+            PrimeIterator(BasicMagicalContainer& container) requires (tracks_primes);
+            // a view of the primes in [lo, hi) only, starting at its first one
+            PrimeIterator(BasicMagicalContainer& container, const T& lo, const T& hi) requires (tracks_primes);
             
             // copy constructor
             PrimeIterator(const PrimeIterator& other);
@@ -155,13 +480,35 @@ class MagicalContainer {
              // inequality comparison
             bool operator!=(const PrimeIterator& other) const;
             // dereference operator
-            int& operator*() const;
+            const T& operator*() const;
             // GT
             bool operator>(const PrimeIterator& other) const;
             // LT
             bool operator<(const PrimeIterator& other) const;
+            bool operator>=(const PrimeIterator& other) const;
+            bool operator<=(const PrimeIterator& other) const;
+            const T* operator->() const;
             // pre increment
             PrimeIterator& operator++();
+            PrimeIterator operator++(int);
+            // pre decrement
+            PrimeIterator& operator--();
+            PrimeIterator operator--(int);
+
+            // random access by rank among the primes
+            PrimeIterator& operator+=(difference_type steps);
+            PrimeIterator& operator-=(difference_type steps);
+            PrimeIterator operator+(difference_type steps) const;
+            PrimeIterator operator-(difference_type steps) const;
+            difference_type operator-(const PrimeIterator& other) const;
+            const T& operator[](difference_type steps) const;
+
+            friend PrimeIterator operator+(difference_type steps, const PrimeIterator& iterator) {
+                return iterator + steps;
+            }
+
+            // copies up to out.size() elements into out and moves past them
+            size_t next_batch(span<T> out);
 
             PrimeIterator begin();
 
@@ -173,6 +520,78 @@ class MagicalContainer {
 
         };
 
+        // MergedAscendingIterator
+        class MergedAscendingIterator {
+        private:
+            // the position in one container, the node is valid while 
+            // version matches the version of its tree
+            struct Cursor {
+                BasicMagicalContainer* container;
+                size_t index;
+                handle node;
+                size_t version;
+            };
+
+            // shared by the copies, so comparing two iterators is O(1)
+            shared_ptr<const vector<BasicMagicalContainer*>> containers;
+            mutable vector<Cursor> cursors;
+            // losers[0] is the winner, losers[1..N-1] the losers of the 
+            // matches, cursor i is the leaf N + i
+            mutable vector<size_t> losers;
+            // elements passed so far, the sum of the cursor indexes
+            size_t index;
+
+            MergedAscendingIterator(shared_ptr<const vector<BasicMagicalContainer*>> shared, bool atEnd);
+
+            bool beats(size_t first, size_t second) const;
+            void build() const;
+            void refresh() const;
+            void checkSameContainers(const MergedAscendingIterator& other, const char* where) const;
+        public:
+            // constructor - the containers are merged in this order
+            MergedAscendingIterator(const vector<BasicMagicalContainer*>& merged);
+            MergedAscendingIterator(initializer_list<BasicMagicalContainer*> merged);
+
+            // copy constructor
+            MergedAscendingIterator(const MergedAscendingIterator& other);
+            // destructor
+            ~MergedAscendingIterator();
+            // assignment operator
+            MergedAscendingIterator& operator=(const MergedAscendingIterator& other);
+            // equality comparison
+            bool operator==(const MergedAscendingIterator& other) const;
+            // inequality comparison
+            bool operator!=(const MergedAscendingIterator& other) const;
+            // dereference operator
+            const T& operator*() const;
+            // GT
+            bool operator>(const MergedAscendingIterator& other) const;
+            // LT
+            bool operator<(const MergedAscendingIterator& other) const;
+            // pre increment
+            MergedAscendingIterator& operator++();
+
+            MergedAscendingIterator begin();
+
+            MergedAscendingIterator end();
+
+            MergedAscendingIterator(MergedAscendingIterator&&) = default;
+            MergedAscendingIterator& operator=(MergedAscendingIterator&& other);
+        };
+
+        // the ascending positions of the elements equal to value
+        pair<AscendingIterator, AscendingIterator> equal_range(const T& value);
+
     };
 
-} 
+// the container of the assignment
+using MagicalContainer = BasicMagicalContainer<int>;
+
+}
+
+#include "MagicalContainerImpl.hpp"
+
+namespace ariel {
+    // instantiated once in MagicalContainer.cpp
+    extern template class BasicMagicalContainer<int>;
+}
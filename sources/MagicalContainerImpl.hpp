@@ -0,0 +1,1973 @@
+/*                   MagicalContainerImpl.hpp
+   ======================================================================
+   The definitions of the BasicMagicalContainer members and of its 
+   iterators. Included at the end of MagicalContainer.hpp, the class 
+   is a template so every translation unit needs the definitions.
+   ======================================================================
+*/
+
+#pragma once
+
+#include "MagicalContainer.hpp"
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+/* Web sources:
+    https://www.techiedelight.com/check-vector-contains-given-element-cpp/
+    https://java2blog.com/remove-element-by-value-vector-cpp/
+    https://cp-algorithms.com/data_structures/treap.html
+*/
+
+namespace ariel {
+
+    /*                          constructor
+    ======================================================================
+    every internal buffer of the container allocates from resource.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::BasicMagicalContainer(pmr::memory_resource* resource)
+        : ascending_elements(resource), prime_elements(resource), element_counts(resource) {}
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    pmr::memory_resource* BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::memoryResource() const {
+        return this->ascending_elements.memoryResource();
+    }
+
+
+    /*                         isPrimeElement
+    ======================================================================
+    the primality test of Primality.hpp, picked at compile time for the 
+    width of T. an element that is not an integer is never a prime, and 
+    since the check is `if constexpr` the prime tree of such a container 
+    is simply never touched.
+    called once per distinct value: the hash index keeps the result as 
+    the mark of the value (see HashIndex::add), so adding the value again 
+    or removing it reads the mark, and the prime tree keeps the primes so 
+    the PrimeIterator never has to test an element again.
+
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::isPrimeElement(const T& element) {
+        if constexpr (tracks_primes) {
+            return isPrime(element);
+        } else {
+            return false;
+        }
+    }
+
+    /*                           sortBatch
+    ======================================================================
+    sorting a batch in the order of the container. a batch of at least 
+    radix::threshold 32 bit integers in their natural order is radix 
+    sorted (see RadixSort.hpp), every other batch goes to std::sort.
+    the scratch buffer of the radix sort comes from the memory resource 
+    of the container.
+
+    time complexity: O(k) for a radix sorted batch, O(k log k) otherwise.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::sortBatch(pmr::vector<T>& batch) const {
+        if constexpr (RadixSortable<T> && (same_as<Compare, less<T>> || same_as<Compare, less<>>)) {
+            if (batch.size() >= radix::threshold) {
+                radixSort(span<T>(batch), this->memoryResource());
+                return;
+            }
+        }
+        sort(batch.begin(), batch.end(), Compare());
+    }
+
+    /*                          addElement
+    ======================================================================
+    inserting the element to the ascending tree, and to the prime tree 
+    if it is a prime. there is nothing to rebuild - the side cross order 
+    is read straight out of the ascending tree (see SideCrossIterator).
+
+    time complexity:
+    - Counting the element in the hash index: O(1) amortized expected
+    - Inserting to the trees: O(log n) expected
+    - Checking if the element is prime: see Primality.hpp, only for a 
+      value that is not in the container yet (the hash index remembers 
+      the answer for the others)
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::addElement(const T& element) {
+        // the index goes first, it may refuse the element (BoundedUniverseIndex)
+        this->ascending_elements.insert(element);
+        if (this->element_counts.add(element, isPrimeElement)) {
+            this->prime_elements.insert(element);
+        }
+    }
+
+    /*                          addElements
+    ======================================================================
+    adding a whole batch at once:
+    1. sorting a copy of the batch
+    2. inserting the sorted batch to the ascending tree, a big batch is 
+       merged into the tree with one linear merge (see 
+       OrderStatisticTree::insertSorted). the tree goes first, so an index 
+       that refuses the batch leaves the container unchanged.
+    3. counting every element in the hash index, which classifies the 
+       values it has not seen before - a value that is repeated in the 
+       batch or already in the container is not tested again - and 
+       inserting the sorted primes to the prime tree. a big batch whose 
+       values are dense enough is classified by one segmented sieve over 
+       its range instead of a primality test per value (see PrimeSieve), 
+       other batches of 32 bit elements are tested 8 at a time when the 
+       processor has AVX2 (see BatchPrimality.hpp)
+    the container ends up exactly as if the elements were added one by 
+    one with addElement.
+
+    time complexity (k elements in the batch, n in the container):
+    - Sorting the batch: O(k log k), O(k) for a big batch of 32 bit 
+      elements (see sortBatch)
+    - Classifying the primes: one primality test per new value, or 
+      O(max - min) for a sieved batch, or k tests 8 at a time
+    - Inserting to the trees: O(min(k log n, n + k))
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::addElements(span<const T> elements) {
+        pmr::vector<T> batch(elements.begin(), elements.end(), this->memoryResource());
+        this->sortBatch(batch);
+        this->ascending_elements.insertSorted(batch);
+        pmr::vector<T> primes(this->memoryResource());
+        // classify(element, i) is asked for the values that are new, i is their position in the batch
+        auto countAll = [this, &batch, &primes](auto classify) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (this->element_counts.add(batch[i], [&classify, i](const T& element) { return classify(element, i); })) {
+                    primes.push_back(batch[i]);
+                }
+            }
+        };
+        auto testEach = [](const T& element, size_t) { return isPrimeElement(element); };
+        if constexpr (tracks_primes) {
+            // the range of the values that can be primes
+            T smallest = numeric_limits<T>::max();
+            T largest = T(0);
+            for (const T& element : batch) {
+                if (element >= T(2)) {
+                    smallest = min(smallest, element);
+                    largest = max(largest, element);
+                }
+            }
+            if (largest >= T(2) && PrimeSieve<T>::suits(batch.size(), smallest, largest)) {
+                PrimeSieve<T> sieve(smallest, largest, this->memoryResource());
+                countAll([&sieve](const T& element, size_t) { return sieve.contains(element); });
+            } else if (batch.size() >= primality::batch_threshold && isPrimeBatchVectorized<T>()) {
+                pmr::vector<uint8_t> flags(batch.size(), this->memoryResource());
+                isPrimeBatch(span<const T>(batch), span<uint8_t>(flags), this->memoryResource());
+                countAll([&flags](const T&, size_t i) { return flags[i] != 0; });
+            } else {
+                countAll(testEach);
+            }
+            this->prime_elements.insertSorted(primes);
+        } else {
+            countAll(testEach);
+        }
+    }
+
+    /*                    removeElement
+    ======================================================================
+    removing the first occurrence of the element from the ascending tree, 
+    and from the prime tree if it is a prime.
+    the hash index is asked first: when the element is not there we throw 
+    right away, without searching the trees.
+
+    NOTE:
+    If there are duplicates, it will remove only one occurrence of 
+    the element (the hash index keeps a count per value). 
+
+    time complexity:
+    - Looking the element up in the hash index: O(1) expected
+    - Removing from the trees: O(log n) expected, the element is only 
+      marked as removed (a tombstone) until the tree is compacted
+    - Checking if the element is prime: O(1), the mark of the value in 
+      the hash index
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::removeElement(const T& element) {
+        bool prime = false;
+        if (!this->element_counts.remove(element, prime)) {
+            throw std::runtime_error("Element to remove is not exists in the container");
+        }
+        this->ascending_elements.erase(element);
+        if (prime) {
+            this->prime_elements.erase(element);
+        }
+    }
+
+    /*                         removeElements
+    ======================================================================
+    removing one occurrence of every element of the batch, like calling 
+    removeElement for each of them:
+    1. sorting a copy of the batch
+    2. strict mode - checking in the hash index that every element is 
+       there as many times as it is asked for, otherwise throwing before 
+       anything was removed
+    3. taking the elements out of the hash index, an element that is not 
+       there (anymore) is skipped, and the marks of the others tell the 
+       primes apart
+    4. removing what was taken from the trees, a big batch is removed in 
+       one filtering pass and one rebuild (see 
+       OrderStatisticTree::eraseSorted)
+    returns how many elements were removed.
+
+    the iterators stay valid: their positions are ranks, they will see 
+    the container without the removed elements.
+
+    time complexity (k elements in the batch, n in the container):
+    - Sorting the batch: O(k log k)
+    - Hash index: O(k) expected
+    - Removing from the trees: O(min(k log n, n + k))
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    size_t BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::removeElements(span<const T> elements, bool strict) {
+        pmr::vector<T> batch(elements.begin(), elements.end(), this->memoryResource());
+        this->sortBatch(batch);
+
+        if (strict) {
+            for (size_t first = 0, last = 0; first < batch.size(); first = last) {
+                while (last < batch.size() && batch[last] == batch[first]) {
+                    ++last;
+                }
+                if (this->element_counts.count(batch[first]) < last - first) {
+                    throw std::runtime_error("Element to remove is not exists in the container");
+                }
+            }
+        }
+
+        pmr::vector<T> removed(this->memoryResource());
+        pmr::vector<T> primes(this->memoryResource());
+        removed.reserve(batch.size());
+        for (const T& element : batch) {
+            bool prime = false;
+            if (this->element_counts.remove(element, prime)) {
+                removed.push_back(element);
+                if (prime) {
+                    primes.push_back(element);
+                }
+            }
+        }
+
+        this->ascending_elements.eraseSorted(removed);
+        if constexpr (tracks_primes) {
+            this->prime_elements.eraseSorted(primes);
+        }
+        return removed.size();
+    }
+
+    /*                         forgetRemoved
+    ======================================================================
+    after removeIf took elements out of the ascending tree, taking them 
+    out of the hash index and the prime tree too.
+    removed is in ascending order.
+
+    time complexity:
+    - Hash index: O(k) expected
+    - Removing the primes: O(min(k log n, n + k))
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::forgetRemoved(const pmr::vector<T>& removed) {
+        pmr::vector<T> primes(this->memoryResource());
+        for (const T& element : removed) {
+            bool prime = false;
+            if (this->element_counts.remove(element, prime) && prime) {
+                primes.push_back(element);
+            }
+        }
+        this->prime_elements.eraseSorted(primes);
+    }
+
+    /*                          size
+    ======================================================================
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    int BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::size() const {
+        return static_cast<int>(this->ascending_elements.size());
+    }
+
+    /*                         primeCount
+    ======================================================================
+    the size of the prime tree, 0 for a container that does not track 
+    primes (its prime tree stays empty).
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    int BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::primeCount() const {
+        return static_cast<int>(this->prime_elements.size());
+    }
+
+    /*                           reserve
+    ======================================================================
+    makes room for n elements in every array of the ascending tree and in 
+    the hash index. the prime tree is left to grow on demand: how many of 
+    the n elements are primes is not known before they arrive.
+
+    time complexity: O(n) when the arrays grow, O(1) otherwise.
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::reserve(size_t n) {
+        this->ascending_elements.reserve(n);
+        this->element_counts.reserve(n);
+    }
+
+    /*                           capacity
+    ======================================================================
+    how many elements the container holds before its arrays have to grow 
+    (the smaller of the ascending tree and the hash index, the tombstones 
+    that wait for the next compaction take room too).
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    size_t BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::capacity() const {
+        return min(this->ascending_elements.capacity(), this->element_counts.capacity());
+    }
+
+    /*                         shrink_to_fit
+    ======================================================================
+    rebuilds the trees without their tombstones and shrinks every array 
+    (and the hash table) to what the elements need. the iterators stay 
+    valid, their positions do not change.
+
+    time complexity: O(n).
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::shrink_to_fit() {
+        this->ascending_elements.shrink_to_fit();
+        this->prime_elements.shrink_to_fit();
+        this->element_counts.shrink_to_fit();
+    }
+
+    /*                          equal_range
+    ======================================================================
+    two ascending iterators: the first element equal to value and the 
+    element after the last one (both at the same position when value is 
+    not in the container). like any other iterators they stay attached 
+    to the container, they do not follow the equal elements when the 
+    container changes.
+
+    time complexity: O(log n), two searches in the ascending tree.
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::equal_range(const T& value) -> pair<AscendingIterator, AscendingIterator> {
+        AscendingIterator lower(*this);
+        AscendingIterator upper(*this);
+        lower.seek_lower(value);
+        upper.seek_upper(value);
+        return {lower, upper};
+    }
+
+    /*                    setCompactionThreshold
+    ======================================================================
+    removed elements stay in the trees as tombstones until more than 
+    ratio of the nodes of a tree are tombstones, then that tree is rebuilt 
+    without them (see OrderStatisticTree::erase). a lower ratio keeps the 
+    trees tighter, a higher one makes fewer rebuilds. the default is 0.25.
+    the iterators are not affected: their positions count live elements 
+    only, so they point at the same element before and after a rebuild.
+    throws std::invalid_argument when ratio is not in [0, 1].
+
+    time complexity: O(n) when a tree is rebuilt right away, O(1) otherwise.
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::setCompactionThreshold(double ratio) {
+        this->ascending_elements.setCompactionThreshold(ratio);
+        this->prime_elements.setCompactionThreshold(ratio);
+    }
+
+
+
+
+
+
+
+
+
+    /*                          
+    ======================================================================
+                            AscendingIterator
+    ======================================================================
+    */
+
+
+    /*                    
+    ======================================================================
+                                constructor
+    ======================================================================
+    store a pointer to the container in container_ptr.
+    index - to keep track of the current position within the container.
+    when creating an AscendingIterator object, it will store a reference to 
+    the container and initialize the index to 0. The iterator does not hold 
+    any additional memory or duplicate the information from the container.
+
+    time complexity:
+    Initialization of the index member variable: O(1)
+    Therefore, the time complexity is O(1)
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::AscendingIterator(BasicMagicalContainer& container) : container_ptr(&container) {
+        this->index = 0;
+        this->cached_node = Index::npos;
+        this->cached_version = SIZE_MAX;
+    }
+
+    /*
+    ======================================================================
+                          bounded view constructor
+    ======================================================================
+    an iterator over the elements in [lo, hi) only. it keeps the two 
+    bounds and not ranks, their ranks are looked up again (binary search 
+    on the tree) after the container changes, so the view follows the 
+    container like the unbounded one does. ++, --, +=, [] and * check 
+    the position against these ranks instead of 0 and the size. a window 
+    with hi <= lo is empty.
+
+    time complexity: O(log n) for the rank of lo.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::AscendingIterator(BasicMagicalContainer& container, const T& lo, const T& hi) 
+        : container_ptr(&container), index(container.ascending_elements.lowerBound(lo)), cached_node(Index::npos), cached_version(SIZE_MAX), window(in_place, lo, hi) {}
+
+    
+    // default constructor
+    // an iterator of no container, it can only be assigned or compared.
+    // time complexity: O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::AscendingIterator() : container_ptr(nullptr), index(0), cached_node(Index::npos), cached_version(SIZE_MAX) {}
+
+    // copy constructor
+    // time complexity:
+    // Copying the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::AscendingIterator(const AscendingIterator& other): container_ptr(other.container_ptr),index(other.index),cached_node(other.cached_node),cached_version(other.cached_version),window(other.window){}
+
+    /* destructor
+       I don't have any additional resources or dynamically allocated memory to deallocate in the AscendingIterator class, 
+       so I don't need to explicitly implement a destructor. 
+       The compiler will automatically generate a default destructor, which will handle the cleanup of any resources owned by the class.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::~AscendingIterator(){
+
+    }
+
+    // assignment operator
+    // a default constructed iterator takes the container of other, 
+    // otherwise both have to belong to the same container.
+    // time complexity:
+    // Checking if the container_ptr of both iterators is the same: O(1)
+    // Assigning the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator=(const AscendingIterator& other) -> AscendingIterator& {
+        if (this->container_ptr != nullptr && this->container_ptr != other.container_ptr) {
+            throw std::runtime_error("error at : AscendingIterator::operator= , The error: not the same container.");
+        }
+        this->container_ptr = other.container_ptr;
+        this->index = other.index;
+        this->cached_node = other.cached_node;
+        this->cached_version = other.cached_version;
+        this->window = other.window;
+        this->window_version = SIZE_MAX;
+        return *this;
+    }
+
+    // move assignment, the same checks as the assignment operator
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator=(AscendingIterator&& other) -> AscendingIterator& {
+        return *this = static_cast<const AscendingIterator&>(other);
+    }
+
+    // throws when other belongs to another container - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::checkSameContainer(const AscendingIterator& other, const char* where) const {
+        if (this->container_ptr != other.container_ptr) {
+            throw std::runtime_error(string("error at : AscendingIterator::") + where + " , The error: not the same container.");
+        }
+    }
+
+
+    /*
+    ======================================================================
+                                 operator ==
+    ======================================================================                   
+    compare both the container_ptr and index of the current iterator 
+    with the members of the other iterator. 
+    If both the container pointer and the index are equal, we return true, 
+    means that the iterators are pointing to the same element in the 
+    container. Otherwise, we return false, means that the iterators are 
+    different.
+
+    time complexity:
+    - Comparing the container_ptr and index member variables of both iterators: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator==(const AscendingIterator& other) const {
+        
+        return (this->container_ptr == other.container_ptr) && (this->index == other.index);
+    }
+
+    /*
+    ======================================================================
+                                 operator !=
+    ======================================================================                   
+    using the implementation of == 
+
+    time complexity:
+    - Using the implementation of Operator==: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator!=(const AscendingIterator& other) const {
+        return !(*this == other);
+    }
+
+
+
+    /*
+    ======================================================================
+                                   node
+    ======================================================================
+    the tree node of the current position.
+    while the container was not modified the cached node is still right, 
+    otherwise the node at rank index is looked up again, so an element 
+    that was added after the iterator was created is found on its turn.
+
+    time complexity:
+    - Container not modified since the last call: O(1)
+    - Otherwise, selecting the node by rank: O(log n)
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::node() const -> handle {
+        const Index& tree = this->container_ptr->ascending_elements;
+        if (this->cached_version != tree.version()) {
+            this->cached_node = tree.select(this->index);
+            this->cached_version = tree.version();
+        }
+        return this->cached_node;
+    }
+
+    // the ranks of begin() and end(): 0 and the size, or the ranks of lo 
+    // and hi in a bounded view (end never before begin), kept until the 
+    // container changes - O(1), O(log n) for a bounded view after a change
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::bounds() const -> pair<size_t, size_t> {
+        const Index& tree = this->container_ptr->ascending_elements;
+        if (!this->window) {
+            return {0, tree.size()};
+        }
+        if (this->window_version != tree.version()) {
+            size_t first = tree.lowerBound(this->window->first);
+            this->window_ranks = {first, max(first, tree.lowerBound(this->window->second))};
+            this->window_version = tree.version();
+        }
+        return this->window_ranks;
+    }
+
+    /*
+    ======================================================================
+                                 operator *
+    ======================================================================
+
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Finding the node of the current position: O(1), O(log n) right 
+      after the container was modified
+    Therefore, the time complexity is O(1) amortized.
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    const T& BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator*() const {
+        pair<size_t, size_t> ranks = this->bounds();
+        if (this->index < ranks.first || this->index >= ranks.second) {
+            throw std::out_of_range("error at : AscendingIterator::operator* , The error: Iterator is out of range.");
+        }
+        return this->container_ptr->ascending_elements.value(this->node());
+        
+    }
+
+    // operator ->, the address of the element of operator*
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator->() const -> const T* {
+        return &**this;
+    }
+
+
+    /*
+    ======================================================================
+                                 operator ++
+    ======================================================================
+    when the cached node is valid it moves to its successor in the 
+    ascending list of the tree, so the next dereference is O(1) too.
+
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Incrementing the index member variable: O(1)
+    - Moving the cached node to the next one: O(1)
+    Therefore, the time complexity is O(1).
+    */
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator++() -> AscendingIterator& {
+        const Index& tree = container_ptr->ascending_elements;
+        if (this->index >= this->bounds().second) {
+            throw runtime_error("error at: AscendingIterator::operator++, The error: Attempt to increment beyond the end.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = tree.next(this->cached_node);
+        }
+        ++this->index;
+        return *this;
+    }
+
+    // post increment - O(1), returns the iterator from before the step
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator++(int) -> AscendingIterator {
+        AscendingIterator before(*this);
+        ++*this;
+        return before;
+    }
+
+    /*
+    ======================================================================
+                                 operator --
+    ======================================================================
+    the mirror of operator++: the cached node moves to its predecessor 
+    (from the end, to the last node).
+
+    time complexity: O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator--() -> AscendingIterator& {
+        const Index& tree = container_ptr->ascending_elements;
+        if (this->index <= this->bounds().first) {
+            throw runtime_error("error at: AscendingIterator::operator--, The error: Attempt to decrement before the beginning.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = this->index == tree.size() ? tree.back() : tree.prev(this->cached_node);
+        }
+        --this->index;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator--(int) -> AscendingIterator {
+        AscendingIterator before(*this);
+        --*this;
+        return before;
+    }
+
+    /*
+    ======================================================================
+                                 operator +=
+    ======================================================================
+    the position is the rank of the element, so jumping is changing the 
+    index. the cached node is dropped, the next dereference selects the 
+    new one by rank.
+    the result has to stay between begin() and end(), otherwise 
+    std::out_of_range is thrown and the iterator does not move (an 
+    iterator left past the end by removals can only move back).
+
+    time complexity: O(1), the next dereference is O(log n).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator+=(difference_type steps) -> AscendingIterator& {
+        pair<size_t, size_t> ranks = this->bounds();
+        if (steps < 0 ? static_cast<size_t>(-steps) > this->index - min(this->index, ranks.first) : static_cast<size_t>(steps) > ranks.second - min(this->index, ranks.second)) {
+            throw std::out_of_range("error at : AscendingIterator::operator+= , The error: Iterator is out of range.");
+        }
+        if (steps != 0) {
+            this->index = steps < 0 ? this->index - static_cast<size_t>(-steps) : this->index + static_cast<size_t>(steps);
+            this->cached_version = SIZE_MAX;
+        }
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator-=(difference_type steps) -> AscendingIterator& {
+        return *this += -steps;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator+(difference_type steps) const -> AscendingIterator {
+        AscendingIterator moved(*this);
+        moved += steps;
+        return moved;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator-(difference_type steps) const -> AscendingIterator {
+        AscendingIterator moved(*this);
+        moved -= steps;
+        return moved;
+    }
+
+    // the number of steps from other to this iterator - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator-(const AscendingIterator& other) const -> difference_type {
+        this->checkSameContainer(other, "operator-");
+        return static_cast<difference_type>(this->index) - static_cast<difference_type>(other.index);
+    }
+
+    /*
+    ======================================================================
+                                 operator []
+    ======================================================================
+    the element steps positions away, the iterator itself does not move.
+
+    time complexity: O(log n), selecting the node by rank.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator[](difference_type steps) const -> const T& {
+        const Index& tree = this->container_ptr->ascending_elements;
+        difference_type rank = static_cast<difference_type>(this->index) + steps;
+        pair<size_t, size_t> ranks = this->bounds();
+        if (rank < static_cast<difference_type>(ranks.first) || rank >= static_cast<difference_type>(ranks.second)) {
+            throw std::out_of_range("error at : AscendingIterator::operator[] , The error: Iterator is out of range.");
+        }
+        return tree.value(tree.select(static_cast<size_t>(rank)));
+    }
+
+   
+
+    /*
+    ======================================================================
+                                 operator >
+    ======================================================================
+    the iterators are compared by their location in the container and 
+    not by the elements they point to. the index is the rank of the 
+    element in the ascending tree, so comparing the indexes is enough.
+
+    time complexity:
+    -Checking if the container_ptr of both iterators is the same: O(1)
+    -Comparing the indexes: O(1)
+    Therefore, the time complexity is O(1).  
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator>(const AscendingIterator& other) const{
+        this->checkSameContainer(other, "operator>");
+        return this->index > other.index;
+    }
+
+    /*
+    ======================================================================
+                                 operator <
+    ======================================================================
+    using the implementations of operators > and !=
+    if not *this > other and *this != other then true
+
+    time complexity:
+    -Using the implementations of Operator> and Operator!=: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator<(const AscendingIterator& other) const{
+        this->checkSameContainer(other, "operator<");
+        return !(*this > other) && (*this != other);
+    }
+
+    /*
+    ======================================================================
+                           seek_lower / seek_upper
+    ======================================================================
+    moving the iterator to the first element that is not less (lower) or 
+    greater (upper) than value, to end() when there is none. the rank is 
+    found by one descent of the tree and the iterator keeps nothing else, 
+    so it stays live: elements added or removed afterwards are seen like 
+    with any other position. a bounded view clamps the rank to its 
+    window, between begin() and end().
+
+    time complexity: O(log n), the next dereference is O(log n) too.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::seek_lower(const T& value) -> AscendingIterator& {
+        pair<size_t, size_t> ranks = this->bounds();
+        this->index = clamp(this->container_ptr->ascending_elements.lowerBound(value), ranks.first, ranks.second);
+        this->cached_version = SIZE_MAX;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::seek_upper(const T& value) -> AscendingIterator& {
+        pair<size_t, size_t> ranks = this->bounds();
+        this->index = clamp(this->container_ptr->ascending_elements.upperBound(value), ranks.first, ranks.second);
+        this->cached_version = SIZE_MAX;
+        return *this;
+    }
+
+    /*
+    ======================================================================
+                                 next_batch
+    ======================================================================
+    copying the next elements into out in one call instead of a * and a 
+    ++ per element. the node of the current position is found once, then 
+    the tree copies the elements straight off its ascending list (see 
+    gather in the sorted index), and the iterator ends up after the last 
+    element copied with its cached node still valid.
+    returns how many elements were copied: out.size(), or less when the 
+    end comes first (0 at the end, nothing is thrown).
+
+    time complexity: O(k) for k elements, plus O(log n) right after the 
+    container was modified.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    size_t BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::next_batch(span<T> out) {
+        const Index& tree = this->container_ptr->ascending_elements;
+        size_t limit = this->bounds().second;
+        size_t count = min(out.size(), limit - min(this->index, limit));
+        if (count == 0) {
+            return 0;
+        }
+        this->cached_node = tree.gather(this->node(), out.first(count));
+        this->index += count;
+        return count;
+    }
+
+    // >= and <= - O(1), the same checks as > and <
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator>=(const AscendingIterator& other) const {
+        return !(*this < other);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::operator<=(const AscendingIterator& other) const {
+        return !(*this > other);
+    }
+
+    /* time complexity:
+        -Creating a new AscendingIterator object: O(1)
+        -Initializing the index member variable: O(1), the rank of lo in a bounded view: O(log n)
+        Therefore, the time complexity is O(1), O(log n) for a bounded view.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::begin() -> AscendingIterator {
+        AscendingIterator iter(*this);
+        iter.index = this->bounds().first;
+        iter.cached_version = SIZE_MAX;
+        return iter;
+    }
+
+     /* time complexity:
+        - Creating a new AscendingIterator object: O(1)
+        - Setting the index member variable to the size of the ascending tree: O(1), the rank of hi in a bounded view: O(log n)
+        - Therefore, the time complexity is O(1), O(log n) for a bounded view.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::AscendingIterator::end() -> AscendingIterator {
+        AscendingIterator iter(*this);
+        iter.index = this->bounds().second;
+        iter.cached_version = SIZE_MAX;
+        return iter;
+
+    }
+
+
+
+
+
+
+
+
+
+    /*                          
+    ======================================================================
+                            DescendingIterator
+    ======================================================================
+    the ascending order read backwards: the element at position index is 
+    the one of rank size - 1 - index in the ascending tree. the iterator 
+    follows the same rules as the AscendingIterator - the position counts 
+    from the largest element, so an element added after the iterator was 
+    created is visited on its turn, the cached node is walked with the 
+    prev links of the tree and looked up again after a modification.
+    */
+
+    // constructors - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::DescendingIterator() : container_ptr(nullptr), index(0), cached_node(Index::npos), cached_version(SIZE_MAX) {}
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::DescendingIterator(BasicMagicalContainer& container) : container_ptr(&container), index(0), cached_node(Index::npos), cached_version(SIZE_MAX) {}
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::DescendingIterator(const DescendingIterator& other) : container_ptr(other.container_ptr), index(other.index), cached_node(other.cached_node), cached_version(other.cached_version) {}
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::~DescendingIterator() {}
+
+    // assignment operator
+    // a default constructed iterator takes the container of other, 
+    // otherwise both have to belong to the same container - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator=(const DescendingIterator& other) -> DescendingIterator& {
+        if (this->container_ptr != nullptr && this->container_ptr != other.container_ptr) {
+            throw std::runtime_error("error at : DescendingIterator::operator= , The error: not the same container.");
+        }
+        this->container_ptr = other.container_ptr;
+        this->index = other.index;
+        this->cached_node = other.cached_node;
+        this->cached_version = other.cached_version;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator=(DescendingIterator&& other) -> DescendingIterator& {
+        return *this = static_cast<const DescendingIterator&>(other);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::checkSameContainer(const DescendingIterator& other, const char* where) const {
+        if (this->container_ptr != other.container_ptr) {
+            throw std::runtime_error(string("error at : DescendingIterator::") + where + " , The error: not the same container.");
+        }
+    }
+
+    // == and != compare the container and the position - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator==(const DescendingIterator& other) const {
+        return (this->container_ptr == other.container_ptr) && (this->index == other.index);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator!=(const DescendingIterator& other) const {
+        return !(*this == other);
+    }
+
+    /*
+    ======================================================================
+                                   node
+    ======================================================================
+    the tree node of the current position, looked up again by rank only 
+    after the container was modified.
+
+    time complexity: O(1), O(log n) right after a modification.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::node() const -> handle {
+        const Index& tree = this->container_ptr->ascending_elements;
+        if (this->cached_version != tree.version()) {
+            this->cached_node = this->index < tree.size() ? tree.select(tree.size() - 1 - this->index) : Index::npos;
+            this->cached_version = tree.version();
+        }
+        return this->cached_node;
+    }
+
+    // operator * - O(1) amortized
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    const T& BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator*() const {
+        if (this->index >= this->container_ptr->ascending_elements.size()) {
+            throw std::out_of_range("error at : DescendingIterator::operator* , The error: Iterator is out of range.");
+        }
+        return this->container_ptr->ascending_elements.value(this->node());
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator->() const -> const T* {
+        return &**this;
+    }
+
+    // > and < compare the positions, not the elements - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator>(const DescendingIterator& other) const {
+        this->checkSameContainer(other, "operator>");
+        return this->index > other.index;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator<(const DescendingIterator& other) const {
+        this->checkSameContainer(other, "operator<");
+        return this->index < other.index;
+    }
+
+    /*
+    ======================================================================
+                              operator ++ / --
+    ======================================================================
+    ++ moves the cached node to its predecessor in the ascending list of 
+    the tree (the next smaller element), -- to its successor (from the 
+    end, to the smallest element).
+
+    time complexity: O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator++() -> DescendingIterator& {
+        const Index& tree = this->container_ptr->ascending_elements;
+        if (this->index >= tree.size()) {
+            throw runtime_error("error at: DescendingIterator::operator++, The error: Attempt to increment beyond the end.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = tree.prev(this->cached_node);
+        }
+        ++this->index;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator++(int) -> DescendingIterator {
+        DescendingIterator before(*this);
+        ++*this;
+        return before;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator--() -> DescendingIterator& {
+        const Index& tree = this->container_ptr->ascending_elements;
+        if (this->index == 0) {
+            throw runtime_error("error at: DescendingIterator::operator--, The error: Attempt to decrement before the beginning.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = this->index == tree.size() ? tree.front() : tree.next(this->cached_node);
+        }
+        --this->index;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::operator--(int) -> DescendingIterator {
+        DescendingIterator before(*this);
+        --*this;
+        return before;
+    }
+
+    // begin - the largest element, end - one past the smallest - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::begin() -> DescendingIterator {
+        return DescendingIterator(*this->container_ptr);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::DescendingIterator::end() -> DescendingIterator {
+        DescendingIterator iter(*this->container_ptr);
+        iter.index = this->container_ptr->ascending_elements.size();
+        return iter;
+    }
+
+
+    /*                          
+    ======================================================================
+                            SideCrossIterator
+    ======================================================================
+    */
+
+
+
+
+
+
+
+    /*                    
+    ======================================================================
+                                constructor
+    ======================================================================
+    store a reference to the container in container_ptr.
+    index - to keep track of the current position within the container.
+    when creating an SideCrossIterator object, it will store a reference to 
+    the container and initialize the index to 0. The iterator does not hold 
+    any additional memory or duplicate the information from the container.
+
+    time complexity:
+    Initialization of the index member variable: O(1)
+    Therefore, the time complexity is O(1)
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::SideCrossIterator(BasicMagicalContainer& container) : container_ptr(container){
+        this->index = 0;
+        this->cached_front = Index::npos;
+        this->cached_back = Index::npos;
+        this->cached_version = SIZE_MAX;
+    }
+
+    
+
+    // copy constructor
+    // time complexity:
+    // Copying the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::SideCrossIterator(const SideCrossIterator& other): container_ptr(other.container_ptr),index(other.index),cached_front(other.cached_front),cached_back(other.cached_back),cached_version(other.cached_version){}
+
+    /* destructor
+       I don't have any additional resources or dynamically allocated memory to deallocate in the SideCrossIterator class, 
+       so I don't need to explicitly implement a destructor. 
+       The compiler will automatically generate a default destructor, which will handle the cleanup of any resources owned by the class.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::~SideCrossIterator(){
+
+    }
+
+    // assignment operator
+    // time complexity:
+    // Checking if the container_ptr of both iterators is the same: O(1)
+    // Assigning the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator=(const SideCrossIterator& other) -> SideCrossIterator& {
+        if (&this->container_ptr != &other.container_ptr) {
+            throw std::runtime_error("error at : SideCrossIterator::operator= , The error: not the same container.");
+        }
+        this->index = other.index;
+        this->cached_front = other.cached_front;
+        this->cached_back = other.cached_back;
+        this->cached_version = other.cached_version;
+        return *this;
+    }
+
+
+
+    /*
+    ======================================================================
+                                 operator ==
+    ======================================================================                   
+    compare both the container_ptr and index of the current iterator 
+    with the members of the other iterator. 
+    If both the container pointer and the index are equal, we return true, 
+    means that the iterators are pointing to the same element in the 
+    container. Otherwise, we return false, means that the iterators are 
+    different.
+
+    time complexity:
+    - Comparing the container_ptr and index member variables of both iterators: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator==(const SideCrossIterator& other) const {
+        return (&this->container_ptr == &other.container_ptr) && (this->index == other.index);
+    }
+
+
+    /*
+    ======================================================================
+                                 operator !=
+    ======================================================================                   
+    using the implementation of == 
+
+    time complexity:
+    - Using the implementation of Operator==: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator!=(const SideCrossIterator& other) const {
+        return !(*this == other);
+    }
+
+
+
+    /*
+    ======================================================================
+                                 refresh
+    ======================================================================
+    the side cross order is not stored anywhere, it is read out of the 
+    ascending tree: position i is the element of rank i/2 when i is even 
+    (taken from the front) and of rank size-1-i/2 when i is odd (taken 
+    from the back).
+    the iterator keeps the node of the next element from the front 
+    (rank (i+1)/2) and of the next element from the back (rank 
+    size-1-i/2). when the container was modified both are looked up again.
+
+    time complexity:
+    - Container not modified since the last call: O(1)
+    - Otherwise, selecting the two nodes by rank: O(log n)
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::refresh() const {
+        const Index& tree = this->container_ptr.ascending_elements;
+        if (this->cached_version != tree.version()) {
+            size_t size = tree.size();
+            this->cached_front = tree.select((this->index + 1) / 2);
+            this->cached_back = this->index / 2 < size ? tree.select(size - 1 - this->index / 2) : Index::npos;
+            this->cached_version = tree.version();
+        }
+    }
+
+    /*
+    ======================================================================
+                                 operator *
+    ======================================================================
+
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Finding the node of the current position: O(1), O(log n) right 
+      after the container was modified
+    Therefore, the time complexity is O(1) amortized.
+
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    const T& BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator*() const {
+        const Index& tree = this->container_ptr.ascending_elements;
+        if (this->index >= tree.size()) {
+            throw std::out_of_range("Iterator is out of range.");
+        }
+        this->refresh();
+        return tree.value(this->index % 2 == 0 ? this->cached_front : this->cached_back);
+    }
+
+
+
+    /*
+    ======================================================================
+                                 operator ++
+    ======================================================================
+    after taking an element from the front the front node moves forward, 
+    after taking an element from the back the back node moves backward.
+
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Incrementing the index member variable: O(1)
+    - Moving one of the cached nodes: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator++() -> SideCrossIterator& {
+        const Index& tree = container_ptr.ascending_elements;
+        if (index >= tree.size()) {
+            throw runtime_error("error at: SideCrossIterator::operator++, The error: Attempt to increment beyond the end.");
+        }
+        if (this->cached_version == tree.version()) {
+            if (this->index % 2 == 0) {
+                this->cached_front = tree.next(this->cached_front);
+            } else {
+                this->cached_back = tree.prev(this->cached_back);
+            }
+        }
+        ++this->index;
+        return *this;
+    }
+
+    /*
+    ======================================================================
+                                 next_batch
+    ======================================================================
+    copying the next elements of the side cross order into out. after an 
+    odd start (the next element comes from the back) the elements are 
+    written in pairs, the smallest left from the front and the largest 
+    left from the back, so both cached nodes move once per pair.
+    returns how many elements were copied (0 at the end).
+
+    time complexity: O(k) for k elements, plus O(log n) right after the 
+    container was modified.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    size_t BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::next_batch(span<T> out) {
+        const Index& tree = this->container_ptr.ascending_elements;
+        size_t count = min(out.size(), tree.size() - min(this->index, tree.size()));
+        if (count == 0) {
+            return 0;
+        }
+        this->refresh();
+        size_t written = 0;
+        if (this->index % 2 == 1) {
+            out[written++] = tree.value(this->cached_back);
+            this->cached_back = tree.prev(this->cached_back);
+        }
+        for (; written + 2 <= count; written += 2) {
+            out[written] = tree.value(this->cached_front);
+            out[written + 1] = tree.value(this->cached_back);
+            this->cached_front = tree.next(this->cached_front);
+            this->cached_back = tree.prev(this->cached_back);
+        }
+        if (written < count) {
+            out[written++] = tree.value(this->cached_front);
+            this->cached_front = tree.next(this->cached_front);
+        }
+        this->index += count;
+        return count;
+    }
+
+    /*
+    ======================================================================
+                                 operator >
+    ======================================================================
+    the iterators are compared by their location in the side cross order 
+    and not by the elements they point to (5>14 for 1,14,2,5,4).
+
+    time complexity:
+    -Checking if the container_ptr of both iterators is the same: O(1)
+    -Comparing the indexes: O(1)
+    Therefore, the time complexity is O(1).  
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator>(const SideCrossIterator& other) const{
+        if (&this->container_ptr != &other.container_ptr) {
+            throw std::runtime_error("error at : SideCrossIterator::operator> , The error: not the same container.");
+        }
+
+        return this->index > other.index;
+    }
+    
+    /*
+    ======================================================================
+                                 operator <
+    ======================================================================
+    using the implementations of operators > and !=
+    if not *this > other and *this != other then true
+
+    time complexity:
+    -Using the implementations of Operator> and Operator!=: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::operator<(const SideCrossIterator& other) const{
+        return !(*this > other) && (*this != other);
+    }
+
+
+    /* time complexity:
+        -Creating a new SideCrossIterator object: O(1)
+        -Initializing the index member variable: O(1)
+        Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::begin() -> SideCrossIterator {
+        SideCrossIterator iter(this->container_ptr);
+        iter.index = 0;
+        return iter;
+    }
+
+    /* time complexity:
+        - Creating a new SideCrossIterator object: O(1)
+        - Setting the index member variable to the size of the container: O(1)
+        - Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::SideCrossIterator::end() -> SideCrossIterator {
+        SideCrossIterator iter(this->container_ptr);
+        iter.index=this->container_ptr.ascending_elements.size();
+        return iter;
+    }
+
+
+
+
+
+
+
+
+    /*                          
+    ======================================================================
+                            PrimeIterator
+    ======================================================================
+    */
+
+
+
+
+
+
+     /*                    
+    ======================================================================
+                                constructor
+    ======================================================================
+    store a reference to the container in container_ptr.
+    index - to keep track of the current position within the container.
+    when creating an PrimeIterator object, it will store a reference to 
+    the container and initialize the index to 0. The iterator does not hold 
+    any additional memory or duplicate the information from the container.
+
+    time complexity:
+    Initialization of the index member variable: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::PrimeIterator(BasicMagicalContainer& container) requires (tracks_primes) : container_ptr(container){
+        this->index = 0;
+        this->cached_node = Index::npos;
+        this->cached_version = SIZE_MAX;
+    }
+
+    // bounded view constructor - the primes in [lo, hi) only, found on the 
+    // prime tree like the bounded AscendingIterator. time complexity: O(log n)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::PrimeIterator(BasicMagicalContainer& container, const T& lo, const T& hi) requires (tracks_primes)
+        : container_ptr(container), index(container.prime_elements.lowerBound(lo)), cached_node(Index::npos), cached_version(SIZE_MAX), window(in_place, lo, hi) {}
+    
+    // copy constructor
+    // time complexity:
+    // Copying the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::PrimeIterator(const PrimeIterator& other): container_ptr(other.container_ptr),index(other.index),cached_node(other.cached_node),cached_version(other.cached_version),window(other.window){}
+    
+    /* destructor
+       I don't have any additional resources or dynamically allocated memory to deallocate in the PrimeIterator class, 
+       so I don't need to explicitly implement a destructor. 
+       The compiler will automatically generate a default destructor, which will handle the cleanup of any resources owned by the class.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::~PrimeIterator(){}
+    
+    // assignment operator
+    // time complexity:
+    // Checking if the container_ptr of both iterators is the same: O(1)
+    // Assigning the container_ptr and index member variables: O(1)
+    // Therefore, the time complexity is O(1).
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator=(const PrimeIterator& other) -> PrimeIterator& {
+        if (&this->container_ptr != &other.container_ptr) {
+            throw std::runtime_error("error at : PrimeIterator::operator= , The error: not the same container.");
+        }
+        this->index = other.index;
+        this->cached_node = other.cached_node;
+        this->cached_version = other.cached_version;
+        this->window = other.window;
+        this->window_version = SIZE_MAX;
+        return *this;
+    }
+
+
+
+
+    /*
+    ======================================================================
+                                 operator ==
+    ======================================================================                   
+    compare both the container_ptr and index of the current iterator 
+    with the members of the other iterator. 
+    If both the container pointer and the index are equal, we return true, 
+    means that the iterators are pointing to the same element in the 
+    container. Otherwise, we return false, means that the iterators are 
+    different.
+
+    time complexity:
+    - Comparing the container_ptr and index member variables of both iterators: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator==(const PrimeIterator& other) const {
+        return (&this->container_ptr == &other.container_ptr) && (this->index == other.index);
+    }
+
+
+
+    /*
+    ======================================================================
+                                 operator !=
+    ======================================================================                   
+    using the implementation of == 
+
+    time complexity:
+    - Using the implementation of Operator==: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator!=(const PrimeIterator& other) const {
+        return !(*this == other);
+    }
+
+
+
+    /*
+    ======================================================================
+                                   node
+    ======================================================================
+    the node of the current position in the prime tree, see 
+    AscendingIterator::node.
+
+    time complexity:
+    - Container not modified since the last call: O(1)
+    - Otherwise, selecting the node by rank: O(log n)
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::node() const -> handle {
+        const Index& tree = this->container_ptr.prime_elements;
+        if (this->cached_version != tree.version()) {
+            this->cached_node = tree.select(this->index);
+            this->cached_version = tree.version();
+        }
+        return this->cached_node;
+    }
+
+    // the ranks of begin() and end() among the primes, see 
+    // AscendingIterator::bounds - O(1), O(log n) for a bounded view after a change
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::bounds() const -> pair<size_t, size_t> {
+        const Index& tree = this->container_ptr.prime_elements;
+        if (!this->window) {
+            return {0, tree.size()};
+        }
+        if (this->window_version != tree.version()) {
+            size_t first = tree.lowerBound(this->window->first);
+            this->window_ranks = {first, max(first, tree.lowerBound(this->window->second))};
+            this->window_version = tree.version();
+        }
+        return this->window_ranks;
+    }
+
+    /*
+    ======================================================================
+                                 operator *
+    ======================================================================
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Finding the node of the current position: O(1), O(log n) right 
+      after the container was modified
+    Therefore, the time complexity is O(1) amortized.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    const T& BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator*() const {
+        pair<size_t, size_t> ranks = this->bounds();
+        if (this->index < ranks.first || this->index >= ranks.second) {
+            throw std::out_of_range("Iterator is out of range.");
+        }
+        return this->container_ptr.prime_elements.value(this->node());
+    }
+
+
+
+    /*
+    ======================================================================
+                                 operator ++
+    ======================================================================
+    time complexity:
+    - Checking if the index is within the valid range: O(1)
+    - Incrementing the index member variable: O(1)
+    - Moving the cached node to the next prime: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator++() -> PrimeIterator& {
+        const Index& tree = this->container_ptr.prime_elements;
+        if (this->index >= this->bounds().second) {
+            throw runtime_error("error at: PrimeIterator::operator++, The error: Attempt to increment beyond the end.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = tree.next(this->cached_node);
+        }
+        ++this->index;
+        return *this;
+    }
+
+    // post increment - O(1), returns the iterator from before the step
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator++(int) -> PrimeIterator {
+        PrimeIterator before(*this);
+        ++*this;
+        return before;
+    }
+
+    /*
+    ======================================================================
+                                 operator --
+    ======================================================================
+    the cached node moves to the previous prime (from the end, to the 
+    last one), like AscendingIterator::operator--.
+
+    time complexity: O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator--() -> PrimeIterator& {
+        const Index& tree = this->container_ptr.prime_elements;
+        if (this->index <= this->bounds().first) {
+            throw runtime_error("error at: PrimeIterator::operator--, The error: Attempt to decrement before the beginning.");
+        }
+        if (this->cached_version == tree.version()) {
+            this->cached_node = this->index == tree.size() ? tree.back() : tree.prev(this->cached_node);
+        }
+        --this->index;
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator--(int) -> PrimeIterator {
+        PrimeIterator before(*this);
+        --*this;
+        return before;
+    }
+
+    /*
+    ======================================================================
+                                 operator +=
+    ======================================================================
+    the position is the rank among the primes, so jumping is changing the 
+    index, see AscendingIterator::operator+=. the result has to stay 
+    between the first prime and the end, otherwise std::out_of_range is 
+    thrown and the iterator does not move.
+
+    time complexity: O(1), the next dereference is O(log n).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator+=(difference_type steps) -> PrimeIterator& {
+        pair<size_t, size_t> ranks = this->bounds();
+        if (steps < 0 ? static_cast<size_t>(-steps) > this->index - min(this->index, ranks.first) : static_cast<size_t>(steps) > ranks.second - min(this->index, ranks.second)) {
+            throw std::out_of_range("error at : PrimeIterator::operator+= , The error: Iterator is out of range.");
+        }
+        if (steps != 0) {
+            this->index = steps < 0 ? this->index - static_cast<size_t>(-steps) : this->index + static_cast<size_t>(steps);
+            this->cached_version = SIZE_MAX;
+        }
+        return *this;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator-=(difference_type steps) -> PrimeIterator& {
+        return *this += -steps;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator+(difference_type steps) const -> PrimeIterator {
+        PrimeIterator moved(*this);
+        moved += steps;
+        return moved;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator-(difference_type steps) const -> PrimeIterator {
+        PrimeIterator moved(*this);
+        moved -= steps;
+        return moved;
+    }
+
+    // the number of primes from other to this iterator - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator-(const PrimeIterator& other) const -> difference_type {
+        if (&this->container_ptr != &other.container_ptr) {
+            throw std::runtime_error("error at : PrimeIterator::operator- , The error: not the same container.");
+        }
+        return static_cast<difference_type>(this->index) - static_cast<difference_type>(other.index);
+    }
+
+    /*
+    ======================================================================
+                                 operator []
+    ======================================================================
+    the prime steps positions away, the iterator itself does not move.
+
+    time complexity: O(log n), selecting the node by rank.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator[](difference_type steps) const -> const T& {
+        const Index& tree = this->container_ptr.prime_elements;
+        difference_type rank = static_cast<difference_type>(this->index) + steps;
+        pair<size_t, size_t> ranks = this->bounds();
+        if (rank < static_cast<difference_type>(ranks.first) || rank >= static_cast<difference_type>(ranks.second)) {
+            throw std::out_of_range("error at : PrimeIterator::operator[] , The error: Iterator is out of range.");
+        }
+        return tree.value(tree.select(static_cast<size_t>(rank)));
+    }
+
+    // operator ->, the address of the element of operator*
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator->() const -> const T* {
+        return &**this;
+    }
+
+    /*
+    ======================================================================
+                                 next_batch
+    ======================================================================
+    copying the next primes into out, straight off the ascending list of 
+    the prime tree like AscendingIterator::next_batch does.
+    returns how many primes were copied (0 at the end).
+
+    time complexity: O(k) for k elements, plus O(log n) right after the 
+    container was modified.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    size_t BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::next_batch(span<T> out) {
+        const Index& tree = this->container_ptr.prime_elements;
+        size_t limit = this->bounds().second;
+        size_t count = min(out.size(), limit - min(this->index, limit));
+        if (count == 0) {
+            return 0;
+        }
+        this->cached_node = tree.gather(this->node(), out.first(count));
+        this->index += count;
+        return count;
+    }
+
+    /*
+    ======================================================================
+                                 operator >
+    ======================================================================
+    the iterators are compared by their location among the primes and not 
+    by the elements they point to.
+
+    time complexity:
+    - Checking if the container_ptr of both iterators is the same: O(1)
+    - Comparing the indexes: O(1)
+    Therefore, the time complexity is O(1).   
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator>(const PrimeIterator& other) const{
+        if (&this->container_ptr != &other.container_ptr) {
+            throw std::runtime_error("error at : PrimeIterator::operator> , The error: not the same container.");
+        }
+
+        return this->index > other.index;
+    }
+            
+    /*
+    ======================================================================
+                                 operator <
+    ======================================================================
+    using the implementations of operators > and !=
+    if not *this > other and *this != other then true
+
+    time complexity:
+    - Using the implementations of Operator> and Operator!=: O(1)
+    Therefore, the time complexity is O(1).
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator<(const PrimeIterator& other) const{
+        return !(*this > other) && (*this != other);
+    }
+
+    // time complexity: O(1), see operator> and operator<
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator>=(const PrimeIterator& other) const {
+        return !(*this < other);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::operator<=(const PrimeIterator& other) const {
+        return !(*this > other);
+    }
+
+     /* time complexity:
+        - Creating a new PrimeIterator object: O(1)
+        - Initializing the index member variable: O(1), the rank of lo in a bounded view: O(log n)
+        Therefore, the time complexity is O(1), O(log n) for a bounded view.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::begin() -> PrimeIterator {
+        PrimeIterator iter(*this);
+        iter.index = this->bounds().first;
+        iter.cached_version = SIZE_MAX;
+        return iter;
+    }
+
+    /* time complexity:
+        - Creating a new PrimeIterator object: O(1)
+        - Setting the index member variable to the size of the prime tree: O(1), the rank of hi in a bounded view: O(log n)
+        Therefore, the time complexity is O(1), O(log n) for a bounded view.
+    */
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::PrimeIterator::end() -> PrimeIterator {
+        PrimeIterator iter(*this);
+        iter.index = this->bounds().second;
+        iter.cached_version = SIZE_MAX;
+        return iter;
+    }
+
+    /*
+    ======================================================================
+                          MergedAscendingIterator
+    ======================================================================
+    one ascending stream over the elements of N containers, merged lazily:
+    - every container has a cursor, its rank and the node of that rank in 
+      the ascending tree of the container (like an AscendingIterator).
+    - a loser tree over the N cursors knows which one holds the smallest 
+      current element. it is a complete binary tree with the cursors as 
+      leaves (cursor i is node N + i), every inner node keeps the cursor 
+      that lost the match played there, and node 0 keeps the overall 
+      winner. after the winner moves on, only the matches on the path of 
+      its leaf are played again, against the losers stored on the way: 
+      O(log N) comparisons per step. an exhausted cursor loses every 
+      match, equal elements go to the cursor of the earlier container.
+    the iterator is live over every container: a modified container is 
+    noticed by its version (one pass over the N version counters, no 
+    element is read), its cursor finds the node of its rank again and the 
+    tree is rebuilt with N - 1 matches.
+
+    time complexity:
+    - construction, begin(), end(): O(N) matches, O(N log n) to find the 
+      nodes
+    - operator*, operator++: O(log N) comparisons, plus O(N log n) right 
+      after one of the containers was modified
+    */
+
+    // the shared constructor, the cursors start at the first element or 
+    // after the last one
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::MergedAscendingIterator(shared_ptr<const vector<BasicMagicalContainer*>> shared, bool atEnd) 
+        : containers(std::move(shared)), index(0) {
+        this->cursors.reserve(this->containers->size());
+        for (BasicMagicalContainer* container : *this->containers) {
+            if (container == nullptr) {
+                throw std::runtime_error("error at : MergedAscendingIterator , The error: null container.");
+            }
+            size_t start = atEnd ? container->ascending_elements.size() : 0;
+            this->cursors.push_back(Cursor{container, start, Index::npos, SIZE_MAX});
+            this->index += start;
+        }
+        this->losers.resize(max<size_t>(this->cursors.size(), 1));
+        this->refresh();
+    }
+
+    // constructor - O(N) matches
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::MergedAscendingIterator(const vector<BasicMagicalContainer*>& merged) 
+        : MergedAscendingIterator(make_shared<const vector<BasicMagicalContainer*>>(merged), false) {}
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::MergedAscendingIterator(initializer_list<BasicMagicalContainer*> merged) 
+        : MergedAscendingIterator(make_shared<const vector<BasicMagicalContainer*>>(merged), false) {}
+
+    // copy constructor - O(N)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::MergedAscendingIterator(const MergedAscendingIterator& other) 
+        : containers(other.containers), cursors(other.cursors), losers(other.losers), index(other.index) {}
+
+    // destructor - the vectors free themselves
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::~MergedAscendingIterator() {}
+
+    // throws when other merges other containers - O(1) for copies of one 
+    // iterator, O(N) otherwise
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::checkSameContainers(const MergedAscendingIterator& other, const char* where) const {
+        if (this->containers != other.containers && *this->containers != *other.containers) {
+            throw std::runtime_error(string("error at : MergedAscendingIterator::") + where + " , The error: not the same containers.");
+        }
+    }
+
+    // assignment operator - both have to merge the same containers. O(N)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator=(const MergedAscendingIterator& other) -> MergedAscendingIterator& {
+        this->checkSameContainers(other, "operator=");
+        this->containers = other.containers;
+        this->cursors = other.cursors;
+        this->losers = other.losers;
+        this->index = other.index;
+        return *this;
+    }
+
+    // move assignment, the same checks as the assignment operator
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator=(MergedAscendingIterator&& other) -> MergedAscendingIterator& {
+        return *this = static_cast<const MergedAscendingIterator&>(other);
+    }
+
+    // whether the current element of cursor first comes before the one of 
+    // cursor second - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::beats(size_t first, size_t second) const {
+        const Cursor& lhs = this->cursors[first];
+        const Cursor& rhs = this->cursors[second];
+        if (lhs.node == Index::npos || rhs.node == Index::npos) {
+            return rhs.node == Index::npos && (lhs.node != Index::npos || first < second);
+        }
+        const T& left = lhs.container->ascending_elements.value(lhs.node);
+        const T& right = rhs.container->ascending_elements.value(rhs.node);
+        if (Compare()(left, right)) {
+            return true;
+        }
+        return !Compare()(right, left) && first < second;
+    }
+
+    // plays all the matches bottom up, the winners of the subtrees are 
+    // only needed on the way - O(N)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::build() const {
+        size_t count = this->cursors.size();
+        if (count == 0) {
+            return;
+        }
+        vector<size_t> winners(2 * count);
+        for (size_t i = 0; i < count; ++i) {
+            winners[count + i] = i;
+        }
+        for (size_t node = count - 1; node > 0; --node) {
+            size_t left = winners[2 * node];
+            size_t right = winners[2 * node + 1];
+            bool leftWins = this->beats(left, right);
+            winners[node] = leftWins ? left : right;
+            this->losers[node] = leftWins ? right : left;
+        }
+        this->losers[0] = count == 1 ? 0 : winners[1];
+    }
+
+    // finds the nodes of the modified containers again and rebuilds the 
+    // tree if there was one - O(N), O(N log n) after a modification
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    void BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::refresh() const {
+        bool stale = false;
+        for (Cursor& cursor : this->cursors) {
+            const Index& tree = cursor.container->ascending_elements;
+            if (cursor.version != tree.version()) {
+                cursor.node = tree.select(cursor.index);
+                cursor.version = tree.version();
+                stale = true;
+            }
+        }
+        if (stale) {
+            this->build();
+        }
+    }
+
+    // equal when both merge the same containers and passed as many elements - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator==(const MergedAscendingIterator& other) const {
+        return this->index == other.index && (this->containers == other.containers || *this->containers == *other.containers);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator!=(const MergedAscendingIterator& other) const {
+        return !(*this == other);
+    }
+
+    // the smallest current element, throws out_of_range at the end
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    const T& BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator*() const {
+        this->refresh();
+        if (this->cursors.empty() || this->cursors[this->losers[0]].node == Index::npos) {
+            throw std::out_of_range("error at : MergedAscendingIterator::operator* , The error: Iterator is out of range.");
+        }
+        const Cursor& winner = this->cursors[this->losers[0]];
+        return winner.container->ascending_elements.value(winner.node);
+    }
+
+    // moves the winner forward and replays the matches of its leaf
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator++() -> MergedAscendingIterator& {
+        this->refresh();
+        if (this->cursors.empty() || this->cursors[this->losers[0]].node == Index::npos) {
+            throw runtime_error("error at: MergedAscendingIterator::operator++, The error: Attempt to increment beyond the end.");
+        }
+        size_t winner = this->losers[0];
+        Cursor& cursor = this->cursors[winner];
+        cursor.node = cursor.container->ascending_elements.next(cursor.node);
+        ++cursor.index;
+        ++this->index;
+        for (size_t node = (this->cursors.size() + winner) / 2; node > 0; node /= 2) {
+            if (this->beats(this->losers[node], winner)) {
+                swap(this->losers[node], winner);
+            }
+        }
+        this->losers[0] = winner;
+        return *this;
+    }
+
+    // compared by how many elements they passed - O(1)
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator>(const MergedAscendingIterator& other) const {
+        this->checkSameContainers(other, "operator>");
+        return this->index > other.index;
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    bool BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::operator<(const MergedAscendingIterator& other) const {
+        this->checkSameContainers(other, "operator<");
+        return this->index < other.index;
+    }
+
+    // begin / end - O(N) matches
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::begin() -> MergedAscendingIterator {
+        return MergedAscendingIterator(this->containers, false);
+    }
+
+    template <typename T, typename Compare, size_t InlineCapacity, typename Growth, template <typename, typename, size_t, typename> class SortedIndex>
+    auto BasicMagicalContainer<T, Compare, InlineCapacity, Growth, SortedIndex>::MergedAscendingIterator::end() -> MergedAscendingIterator {
+        return MergedAscendingIterator(this->containers, true);
+    }
+}
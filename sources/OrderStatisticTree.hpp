@@ -0,0 +1,793 @@
+/*                   OrderStatisticTree.hpp
+   ======================================================================
+   This header file defines the OrderStatisticTree class, the sorted
+   index that backs the MagicalContainer, and RunLengthTree, the same
+   tree in multiset mode.
+
+   The tree is a treap (a binary search tree whose nodes also keep a
+   random priority in heap order), so its expected height is O(log n)
+   no matter in which order the elements arrive.
+   Every node also stores the size of its subtree, which turns it into
+   an order-statistic tree:
+   - select(rank): the position of the rank-th smallest element.
+   - lowerBound(value) / upperBound(value): the rank of the first element
+     that is not less / greater than value.
+
+   Besides the tree links, the nodes are threaded in a doubly linked list
+   in ascending order (next / prev), so walking the elements in order
+   costs O(1) per step and never has to climb back up the tree.
+
+   The nodes refer to each other by index instead of by pointer, and a
+   node is not one struct but the same index in four parallel arrays
+   (structure of arrays), each holding what one kind of access reads:
+   - values:     the elements, read by operator* of the iterators.
+   - order:      the prev / next links, read by operator++.
+   - branches:   the left / right links, the subtree size and the count
+                 of the node, read by select, lowerBound and upperBound.
+   - priorities: read only while the tree is restructured.
+   So walking the elements touches two dense arrays (8 bytes of links
+   and one value per element) instead of dragging whole nodes (28 bytes
+   for int) through the cache.
+   The first InlineCapacity nodes of every array are stored inside the
+   tree object (SmallVector), so a small tree never allocates. Beyond
+   that the four arrays grow together by the Growth policy, and
+   reserve() / shrink_to_fit() size all four of them at once.
+
+   Every node counts the occurrences it holds, and the subtree sizes add
+   up the counts. In the OrderStatisticTree every element has a node of
+   its own (count 1). The RunLengthTree (RunLength = true) keeps one
+   node per distinct value instead, a run of (value, count): adding a
+   value that is already there and removing one that is left more than
+   once only change the counts on one path from the root, O(log n), and
+   the memory grows with the number of distinct values, not with the
+   number of elements. A position (handle) in the RunLengthTree is the
+   node and the occurrence inside its run, so select and next / prev
+   still go through every occurrence one by one.
+
+   erase() does not take the node out of the tree, it leaves a tombstone:
+   the node is marked dead (count 0), unlinked from the ascending list
+   and the subtree sizes on its path lose one, all in one descent from
+   the root with no restructuring. Sizes and ranks count the live
+   occurrences only, so nobody but the tree sees the tombstones. When the
+   tombstones pass the compaction threshold (a fraction of all the nodes
+   in the tree), the tree is rebuilt from the live runs in linear time,
+   which keeps the height O(log n) and the memory O(n). insert() also
+   rebuilds instead of growing the arrays when they are full and hold
+   tombstones.
+
+   Everything the tree allocates, including the temporary arrays of the
+   batch operations, comes from the std::pmr::memory_resource it was
+   constructed with.
+   Equal elements are kept in insertion order: a new element is placed
+   after all the elements that are equal to it.
+
+   A sorted batch can be inserted or removed in one go (insertSorted,
+   eraseSorted, extractIf): when it is big compared with the tree, the
+   runs are read in order, merged with / filtered by the batch, and the
+   tree is rebuilt from the result in linear time.
+
+   version() is bumped on every modification, so whoever caches a handle
+   (the container iterators) can tell when the cache went stale.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "GrowthPolicy.hpp"
+#include "SmallVector.hpp"
+
+namespace ariel {
+
+template <typename T, typename Compare = std::less<T>, std::size_t InlineCapacity = 0, typename Growth = DoublingGrowth, bool RunLength = false>
+class BasicOrderStatisticTree {
+    public:
+        // the node, and in a run length tree the occurrence in its run (low 32 bits)
+        using handle = std::conditional_t<RunLength, std::uint64_t, std::uint32_t>;
+        static constexpr handle npos = std::numeric_limits<handle>::max();
+
+    private:
+        using link = std::uint32_t;
+        static constexpr link nil = UINT32_MAX;
+
+        struct Order {
+            link prev;
+            link next;
+        };
+
+        struct Branch {
+            link left;
+            link right;
+            std::uint32_t size;   // live occurrences in the subtree
+            std::uint32_t count;  // occurrences of this node, 0 = tombstone
+        };
+
+        struct Run {
+            T value;
+            std::uint32_t count;
+        };
+
+        // one node = the same index in every array
+        SmallVector<T, InlineCapacity, Growth> values;
+        SmallVector<Order, InlineCapacity, Growth> order;
+        SmallVector<Branch, InlineCapacity, Growth> branches;
+        SmallVector<std::uint32_t, InlineCapacity, Growth> priorities;
+        std::size_t tombstone_count = 0;
+        double compaction_threshold = 0.25;
+        link root = nil;
+        link first = nil;
+        link last = nil;
+        std::uint32_t seed = 0x9E3779B9U;
+        std::size_t modifications = 0;
+        Compare compare;
+
+        static handle place(link node, std::uint32_t offset = 0) {
+            if (node == nil) {
+                return npos;
+            }
+            if constexpr (RunLength) {
+                return (static_cast<handle>(node) << 32U) | offset;
+            } else {
+                return node;
+            }
+        }
+
+        static link nodeOf(handle position) {
+            if constexpr (RunLength) {
+                return static_cast<link>(position >> 32U);
+            } else {
+                return position;
+            }
+        }
+
+        std::uint32_t sizeOf(link node) const {
+            return node == nil ? 0 : this->branches[node].size;
+        }
+
+        void pull(link node) {
+            Branch& current = this->branches[node];
+            current.size = current.count + this->sizeOf(current.left) + this->sizeOf(current.right);
+        }
+
+        // xorshift32 - deterministic, so two runs build the same tree
+        std::uint32_t nextPriority() {
+            this->seed ^= this->seed << 13U;
+            this->seed ^= this->seed >> 17U;
+            this->seed ^= this->seed << 5U;
+            return this->seed;
+        }
+
+        link allocate(const T& value) {
+            this->values.push_back(value);
+            this->order.push_back(Order{nil, nil});
+            this->branches.push_back(Branch{nil, nil, 1, 1});
+            this->priorities.push_back(this->nextPriority());
+            return static_cast<link>(this->values.size() - 1);
+        }
+
+        void clearNodes() {
+            this->values.clear();
+            this->order.clear();
+            this->branches.clear();
+            this->priorities.clear();
+            this->tombstone_count = 0;
+        }
+
+        /* split
+           splits the subtree of node into (elements < value, elements >= value),
+           or into (elements <= value, elements > value) when inclusive is set.
+           time complexity: O(height) = O(log n) expected.
+        */
+        std::pair<link, link> split(link node, const T& value, bool inclusive) {
+            if (node == nil) {
+                return {nil, nil};
+            }
+            const T& key = this->values[node];
+            bool goesLeft = inclusive ? !this->compare(value, key) : this->compare(key, value);
+            if (goesLeft) {
+                auto [lower, upper] = this->split(this->branches[node].right, value, inclusive);
+                this->branches[node].right = lower;
+                this->pull(node);
+                return {node, upper};
+            }
+            auto [lower, upper] = this->split(this->branches[node].left, value, inclusive);
+            this->branches[node].left = upper;
+            this->pull(node);
+            return {lower, node};
+        }
+
+        /* merge
+           joins two subtrees where every element of lower comes before every
+           element of upper.
+           time complexity: O(log n) expected.
+        */
+        link merge(link lower, link upper) {
+            if (lower == nil) {
+                return upper;
+            }
+            if (upper == nil) {
+                return lower;
+            }
+            if (this->priorities[lower] > this->priorities[upper]) {
+                this->branches[lower].right = this->merge(this->branches[lower].right, upper);
+                this->pull(lower);
+                return lower;
+            }
+            this->branches[upper].left = this->merge(lower, this->branches[upper].left);
+            this->pull(upper);
+            return upper;
+        }
+
+        // the last live node of the subtree, nil when it has none
+        link lastAlive(link node) const {
+            while (node != nil && this->branches[node].size != 0) {
+                const Branch& current = this->branches[node];
+                if (this->sizeOf(current.right) != 0) {
+                    node = current.right;
+                } else if (current.count != 0) {
+                    return node;
+                } else {
+                    node = current.left;
+                }
+            }
+            return nil;
+        }
+
+        /* recount
+           adds one occurrence to (grow) or takes one from the node that
+           holds the rank-th live element: the descent that finds it fixes
+           the size of every node on the way, the node itself included.
+           a node whose count drops to 0 is a tombstone.
+           time complexity: O(height) = O(log n) expected.
+        */
+        link recount(std::size_t rank, bool grow) {
+            link node = this->root;
+            while (true) {
+                Branch& current = this->branches[node];
+                current.size = grow ? current.size + 1 : current.size - 1;
+                std::size_t leftSize = this->sizeOf(current.left);
+                if (rank < leftSize) {
+                    node = current.left;
+                } else if (rank < leftSize + current.count) {
+                    current.count = grow ? current.count + 1 : current.count - 1;
+                    return node;
+                } else {
+                    rank -= leftSize + current.count;
+                    node = current.right;
+                }
+            }
+        }
+
+        // rebuilds the tree without tombstones once there are too many of them
+        void compactIfNeeded() {
+            std::size_t nodeCount = this->values.size();
+            if (static_cast<double>(this->tombstone_count) > this->compaction_threshold * static_cast<double>(nodeCount)) {
+                this->build(this->runs());
+                ++this->modifications;
+            }
+        }
+
+        // threads node into the ascending list right after pred (nil = at the front)
+        void linkAfter(link pred, link node) {
+            link succ = pred == nil ? this->first : this->order[pred].next;
+            this->order[node].prev = pred;
+            this->order[node].next = succ;
+            if (pred == nil) {
+                this->first = node;
+            } else {
+                this->order[pred].next = node;
+            }
+            if (succ == nil) {
+                this->last = node;
+            } else {
+                this->order[succ].prev = node;
+            }
+        }
+
+        void unlink(link node) {
+            link pred = this->order[node].prev;
+            link succ = this->order[node].next;
+            if (pred == nil) {
+                this->first = succ;
+            } else {
+                this->order[pred].next = succ;
+            }
+            if (succ == nil) {
+                this->last = pred;
+            } else {
+                this->order[succ].prev = pred;
+            }
+        }
+
+        /* build
+           replaces the whole tree with the ascending runs.
+           the nodes are laid out in ascending order (node i holds the i-th
+           run) and get fresh random priorities. the tree is the Cartesian
+           tree of the priorities, built with a stack of the right spine: a
+           node becomes the left child of the last node it pops and the
+           right child of the node left on top.
+           the subtree of a node covers a contiguous stretch of runs, from
+           the one after the node below it in the stack to the one before
+           the node that pops it, so its size is the difference of the
+           occurrences counted before those two.
+           time complexity: O(n).
+        */
+        template <typename Runs>
+        void build(const Runs& sorted) {
+            this->clearNodes();
+            this->reserve(sorted.size());
+            // the right spine of a treap is O(log n) long, 64 is plenty inline
+            SmallVector<link, 64> spine(this->memoryResource());
+            const auto count = static_cast<link>(sorted.size());
+            std::uint32_t before = 0;  // occurrences in the runs before current
+            for (link current = 0; current < count; ++current) {
+                std::uint32_t priority = this->nextPriority();
+                link popped = nil;
+                while (!spine.empty() && this->priorities[spine.back()] < priority) {
+                    popped = spine.back();
+                    spine.pop_back();
+                    // size holds the occurrences before the subtree until now
+                    this->branches[popped].size = before - this->branches[popped].size;
+                }
+                if (!spine.empty()) {
+                    this->branches[spine.back()].right = current;
+                }
+                this->values.push_back(sorted[current].value);
+                this->order.push_back(Order{current == 0 ? nil : current - 1, current + 1 == count ? nil : current + 1});
+                this->branches.push_back(Branch{popped, nil, before - this->sizeOf(popped), sorted[current].count});
+                this->priorities.push_back(priority);
+                spine.push_back(current);
+                before += sorted[current].count;
+            }
+            for (link node : spine) {
+                this->branches[node].size = before - this->branches[node].size;
+            }
+            this->root = spine.empty() ? nil : spine[0];
+            this->first = count == 0 ? nil : 0;
+            this->last = count == 0 ? nil : count - 1;
+        }
+
+        // appends count occurrences of value to ascending runs
+        template <typename Runs>
+        void appendRun(Runs& runs, const T& value, std::uint32_t count) const {
+            if constexpr (RunLength) {
+                if (!runs.empty() && !this->compare(runs.back().value, value)) {
+                    runs.back().count += count;
+                    return;
+                }
+            }
+            runs.push_back(Run{value, count});
+        }
+
+        // the live runs in ascending order
+        SmallVector<Run, InlineCapacity, Growth> runs() const {
+            SmallVector<Run, InlineCapacity, Growth> current(this->values.memoryResource());
+            current.reserve(this->values.size() - this->tombstone_count);
+            for (link node = this->first; node != nil; node = this->order[node].next) {
+                current.push_back(Run{this->values[node], this->branches[node].count});
+            }
+            return current;
+        }
+
+    public:
+        explicit BasicOrderStatisticTree(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : values(resource), order(resource), branches(resource), priorities(resource) {}
+
+        BasicOrderStatisticTree(const BasicOrderStatisticTree&) = default;
+        BasicOrderStatisticTree& operator=(const BasicOrderStatisticTree&) = default;
+
+        // the moved-from tree is left empty, like after clear()
+        BasicOrderStatisticTree(BasicOrderStatisticTree&& other) noexcept
+            : values(std::move(other.values)), order(std::move(other.order)), branches(std::move(other.branches)), priorities(std::move(other.priorities)),
+              tombstone_count(other.tombstone_count), compaction_threshold(other.compaction_threshold), root(other.root), first(other.first), last(other.last),
+              seed(other.seed), modifications(other.modifications), compare(other.compare) {
+            other.clear();
+        }
+
+        // the version moves past both old ones, so no cached handle survives
+        BasicOrderStatisticTree& operator=(BasicOrderStatisticTree&& other) {
+            if (this != &other) {
+                std::size_t version = std::max(this->modifications, other.modifications) + 1;
+                this->values = std::move(other.values);
+                this->order = std::move(other.order);
+                this->branches = std::move(other.branches);
+                this->priorities = std::move(other.priorities);
+                this->tombstone_count = other.tombstone_count;
+                this->compaction_threshold = other.compaction_threshold;
+                this->root = other.root;
+                this->first = other.first;
+                this->last = other.last;
+                this->seed = other.seed;
+                this->modifications = version;
+                this->compare = other.compare;
+                other.clear();
+            }
+            return *this;
+        }
+
+        std::pmr::memory_resource* memoryResource() const {
+            return this->values.memoryResource();
+        }
+
+        // number of elements, every occurrence counted
+        std::size_t size() const {
+            return this->sizeOf(this->root);
+        }
+
+        bool empty() const {
+            return this->size() == 0;
+        }
+
+        // how many nodes (live ones and tombstones) fit without growing
+        std::size_t capacity() const {
+            return this->values.capacity();
+        }
+
+        // how many nodes hold live elements (distinct values in a run length tree)
+        std::size_t nodes() const {
+            return this->values.size() - this->tombstone_count;
+        }
+
+        /* reserve
+           makes room for capacity nodes in every array, so that many
+           inserts do not reallocate.
+           time complexity: O(n) when the arrays grow, O(1) otherwise.
+        */
+        void reserve(std::size_t capacity) {
+            this->values.reserve(capacity);
+            this->order.reserve(capacity);
+            this->branches.reserve(capacity);
+            this->priorities.reserve(capacity);
+        }
+
+        /* shrink_to_fit
+           drops the tombstones and gives back the memory that is not used
+           by the live nodes.
+           time complexity: O(n).
+        */
+        void shrink_to_fit() {
+            if (this->tombstone_count != 0) {
+                this->build(this->runs());
+                ++this->modifications;
+            }
+            this->values.shrink_to_fit();
+            this->order.shrink_to_fit();
+            this->branches.shrink_to_fit();
+            this->priorities.shrink_to_fit();
+        }
+
+        // erased nodes that are still waiting for the next compaction
+        std::size_t tombstones() const {
+            return this->tombstone_count;
+        }
+
+        /* setCompactionThreshold
+           the tree is rebuilt when more than ratio of its nodes are
+           tombstones: 0 compacts on every erase, 1 never does.
+           throws std::invalid_argument when ratio is not in [0, 1].
+        */
+        void setCompactionThreshold(double ratio) {
+            if (!(ratio >= 0.0 && ratio <= 1.0)) {
+                throw std::invalid_argument("compaction threshold must be between 0 and 1");
+            }
+            this->compaction_threshold = ratio;
+            this->compactIfNeeded();
+        }
+
+        std::size_t version() const {
+            return this->modifications;
+        }
+
+        /* insert
+           places value after all the elements that are equal to it (in a
+           run length tree: one more occurrence in its run).
+           time complexity: O(log n) expected.
+        */
+        void insert(const T& value) {
+            if constexpr (RunLength) {
+                std::size_t rank = this->lowerBound(value);
+                handle found = this->select(rank);
+                if (found != npos && !this->compare(value, this->value(found))) {
+                    this->recount(rank, true);
+                    ++this->modifications;
+                    return;
+                }
+            }
+            // reusing the tombstones is cheaper than growing the arrays
+            if (this->tombstone_count != 0 && this->values.size() == this->values.capacity()) {
+                this->build(this->runs());
+            }
+            link node = this->allocate(value);
+            auto [lower, upper] = this->split(this->root, value, true);
+            this->linkAfter(this->lastAlive(lower), node);
+            this->root = this->merge(this->merge(lower, node), upper);
+            ++this->modifications;
+        }
+
+        /* insertSorted
+           inserts an ascending batch, the result is the same as inserting
+           the values one by one.
+           a batch that is small compared with the tree is inserted one by
+           one, O(k log n). otherwise the runs of the tree are read in
+           order, merged with the batch (the old elements go first among
+           equal ones) and the tree is rebuilt from the merged runs,
+           O(n + k).
+        */
+        void insertSorted(std::span<const T> sorted) {
+            std::size_t total = this->size() + sorted.size();
+            if (sorted.size() * static_cast<std::size_t>(std::bit_width(total)) < total) {
+                for (const T& value : sorted) {
+                    this->insert(value);
+                }
+                return;
+            }
+            SmallVector<Run, InlineCapacity, Growth> current = this->runs();
+            std::pmr::vector<Run> merged(this->values.memoryResource());
+            merged.reserve(current.size() + sorted.size());
+            auto run = current.begin();
+            for (const T& value : sorted) {
+                for (; run != current.end() && !this->compare(value, run->value); ++run) {
+                    this->appendRun(merged, run->value, run->count);
+                }
+                this->appendRun(merged, value, 1);
+            }
+            for (; run != current.end(); ++run) {
+                this->appendRun(merged, run->value, run->count);
+            }
+            this->build(merged);
+            ++this->modifications;
+        }
+
+        /* eraseSorted
+           removes one occurrence for every value of an ascending batch
+           (values that run out are skipped), the result is the same as
+           erasing the values one by one. returns how many were removed.
+           a small batch is erased one by one, O(k log n), otherwise the
+           runs are filtered in one pass and the tree is rebuilt, O(n + k).
+        */
+        std::size_t eraseSorted(std::span<const T> sorted) {
+            std::size_t before = this->size();
+            if (sorted.size() * static_cast<std::size_t>(std::bit_width(before)) < before) {
+                std::size_t removed = 0;
+                for (const T& value : sorted) {
+                    if (this->erase(value)) {
+                        ++removed;
+                    }
+                }
+                return removed;
+            }
+            SmallVector<Run, InlineCapacity, Growth> current = this->runs();
+            std::pmr::vector<Run> kept(this->values.memoryResource());
+            kept.reserve(current.size());
+            std::size_t removed = 0;
+            std::size_t next = 0;
+            for (const Run& run : current) {
+                while (next < sorted.size() && this->compare(sorted[next], run.value)) {
+                    ++next;
+                }
+                std::uint32_t count = run.count;
+                for (; count != 0 && next < sorted.size() && !this->compare(run.value, sorted[next]); ++next) {
+                    --count;
+                    ++removed;
+                }
+                if (count != 0) {
+                    kept.push_back(Run{run.value, count});
+                }
+            }
+            if (removed != 0) {
+                this->build(kept);
+                ++this->modifications;
+            }
+            return removed;
+        }
+
+        /* extractIf
+           removes every element for which predicate returns true, in one
+           pass over the runs and one rebuild, and returns the removed
+           elements in ascending order. predicate is called once per run
+           (once per element in the OrderStatisticTree), a run is removed
+           or kept as a whole.
+           time complexity: O(n).
+        */
+        template <typename Predicate>
+        std::pmr::vector<T> extractIf(Predicate predicate) {
+            std::pmr::vector<Run> kept(this->values.memoryResource());
+            std::pmr::vector<T> removed(this->values.memoryResource());
+            kept.reserve(this->nodes());
+            for (link node = this->first; node != nil; node = this->order[node].next) {
+                const T& value = this->values[node];
+                std::uint32_t count = this->branches[node].count;
+                if (predicate(value)) {
+                    removed.insert(removed.end(), count, value);
+                } else {
+                    kept.push_back(Run{value, count});
+                }
+            }
+            if (!removed.empty()) {
+                this->build(kept);
+                ++this->modifications;
+            }
+            return removed;
+        }
+
+        /* erase
+           removes the first occurrence of value. a node that has no
+           occurrences left becomes a tombstone, and the tree is compacted
+           when there are too many of them.
+           returns false (and leaves the tree untouched) when value is missing.
+           time complexity: O(log n) expected, O(n) for the erase that
+           compacts - O(log n) amortized as long as the threshold is not 0.
+        */
+        bool erase(const T& value) {
+            std::size_t rank = this->lowerBound(value);
+            handle found = this->select(rank);
+            if (found == npos || this->compare(value, this->value(found))) {
+                return false;
+            }
+            link node = this->recount(rank, false);
+            ++this->modifications;
+            if (this->branches[node].count == 0) {
+                this->unlink(node);
+                ++this->tombstone_count;
+                this->compactIfNeeded();
+            }
+            return true;
+        }
+
+        void clear() {
+            this->clearNodes();
+            this->root = nil;
+            this->first = nil;
+            this->last = nil;
+            ++this->modifications;
+        }
+
+        /* select
+           the handle of the rank-th smallest element (0 based),
+           npos when rank is out of range.
+           time complexity: O(log n) expected.
+        */
+        handle select(std::size_t rank) const {
+            if (rank >= this->size()) {
+                return npos;
+            }
+            link node = this->root;
+            while (true) {
+                const Branch& current = this->branches[node];
+                std::size_t leftSize = this->sizeOf(current.left);
+                if (rank < leftSize) {
+                    node = current.left;
+                } else if (rank < leftSize + current.count) {
+                    return place(node, static_cast<std::uint32_t>(rank - leftSize));
+                } else {
+                    rank -= leftSize + current.count;
+                    node = current.right;
+                }
+            }
+        }
+
+        // number of elements less than value - O(log n) expected
+        std::size_t lowerBound(const T& value) const {
+            std::size_t rank = 0;
+            link node = this->root;
+            while (node != nil) {
+                if (this->compare(this->values[node], value)) {
+                    rank += this->sizeOf(this->branches[node].left) + this->branches[node].count;
+                    node = this->branches[node].right;
+                } else {
+                    node = this->branches[node].left;
+                }
+            }
+            return rank;
+        }
+
+        // number of elements not greater than value - O(log n) expected
+        std::size_t upperBound(const T& value) const {
+            std::size_t rank = 0;
+            link node = this->root;
+            while (node != nil) {
+                if (!this->compare(value, this->values[node])) {
+                    rank += this->sizeOf(this->branches[node].left) + this->branches[node].count;
+                    node = this->branches[node].right;
+                } else {
+                    node = this->branches[node].left;
+                }
+            }
+            return rank;
+        }
+
+        // walking the ascending list - O(1)
+        handle front() const {
+            return place(this->first);
+        }
+
+        handle back() const {
+            if constexpr (RunLength) {
+                return this->last == nil ? npos : place(this->last, this->branches[this->last].count - 1);
+            } else {
+                return place(this->last);
+            }
+        }
+
+        handle next(handle position) const {
+            if (position == npos) {
+                return npos;
+            }
+            link node = nodeOf(position);
+            if constexpr (RunLength) {
+                if (static_cast<std::uint32_t>(position) + 1 < this->branches[node].count) {
+                    return position + 1;
+                }
+            }
+            return place(this->order[node].next);
+        }
+
+        handle prev(handle position) const {
+            if (position == npos) {
+                return npos;
+            }
+            link node = nodeOf(position);
+            if constexpr (RunLength) {
+                if (static_cast<std::uint32_t>(position) != 0) {
+                    return position - 1;
+                }
+                link pred = this->order[node].prev;
+                return pred == nil ? npos : place(pred, this->branches[pred].count - 1);
+            } else {
+                return place(this->order[node].prev);
+            }
+        }
+
+        const T& value(handle position) const {
+            return this->values[nodeOf(position)];
+        }
+
+        /* gather
+           copies the elements from position on into out, as many as fit,
+           and returns the position after the last one copied (npos at the
+           end). a run of a run length tree is written with one fill.
+           time complexity: O(k) for k elements.
+        */
+        handle gather(handle position, std::span<T> out) const {
+            std::size_t copied = 0;
+            if constexpr (RunLength) {
+                while (position != npos && copied < out.size()) {
+                    link node = nodeOf(position);
+                    auto offset = static_cast<std::uint32_t>(position);
+                    std::size_t run = std::min<std::size_t>(this->branches[node].count - offset, out.size() - copied);
+                    std::fill_n(out.data() + copied, run, this->values[node]);
+                    copied += run;
+                    position = offset + run < this->branches[node].count ? position + run : place(this->order[node].next);
+                }
+                return position;
+            } else {
+                link node = nodeOf(position);
+                for (; node != nil && copied < out.size(); node = this->order[node].next) {
+                    out[copied++] = this->values[node];
+                }
+                return place(node);
+            }
+        }
+};
+
+// one node per element
+template <typename T, typename Compare = std::less<T>, std::size_t InlineCapacity = 0, typename Growth = DoublingGrowth>
+using OrderStatisticTree = BasicOrderStatisticTree<T, Compare, InlineCapacity, Growth, false>;
+
+// one node per distinct value, holding all its occurrences
+template <typename T, typename Compare = std::less<T>, std::size_t InlineCapacity = 0, typename Growth = DoublingGrowth>
+using RunLengthTree = BasicOrderStatisticTree<T, Compare, InlineCapacity, Growth, true>;
+
+}
@@ -0,0 +1,595 @@
+/*                   PackedMemoryArray.hpp
+   ======================================================================
+   This header file defines the PackedMemoryArray class, a sorted index
+   that can back the MagicalContainer instead of the OrderStatisticTree
+   (it has the same interface, see BasicMagicalContainer).
+
+   A packed memory array keeps the elements sorted in one array with
+   gaps spread between them, so an insert only shifts the elements up to
+   the next gap instead of the whole array:
+   - The array is cut into segments of 64 slots. The elements of a
+     segment are packed at its start, and every segment holds at least
+     one element (as long as the array is not empty).
+   - Inserting into a segment that has room shifts at most 63 elements.
+     A full segment is rebalanced together with its neighbours: the
+     smallest aligned window of 2, 4, 8, ... segments that is not too
+     dense gets its elements spread evenly again. The allowed density
+     goes from 1 for one segment down to 1/2 for the whole array, and
+     when even the whole array is too dense its capacity doubles.
+   - Erasing the last element of a segment rebalances the smallest window
+     that is not too sparse (from 1/64 for one segment up to 1/8 for the
+     whole array, which shrinks to fit when it gets below that).
+   This makes an insert or an erase O(log^2 n) amortized element moves.
+
+   Walking the elements in order is a sequential scan of the array:
+   next() is the following slot, or the first slot of the next segment.
+   A Fenwick tree over the segment counts gives the rank of a segment in
+   O(log n), so select() and lowerBound() / upperBound() are O(log n)
+   (a binary search over the first elements of the segments, then one
+   inside a segment).
+
+   The handles are slot numbers. Every insert or erase may move elements
+   between slots and bumps version(), so a cached handle is only valid
+   while the version did not change (same as with the tree).
+   T has to be default constructible, the gaps hold T().
+   The arrays come from the std::pmr::memory_resource of the index. Their
+   size is always a power of two number of segments, the growth policy
+   does not apply. reserve() only allocates the memory of a bigger array
+   (spreading a few elements over many segments would leave segments
+   empty), the array keeps doubling into it without reallocating.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "GrowthPolicy.hpp"
+#include "SmallVector.hpp"
+
+namespace ariel {
+
+template <typename T, typename Compare = std::less<T>, std::size_t InlineCapacity = 0, typename Growth = DoublingGrowth>
+class PackedMemoryArray {
+    public:
+        using handle = std::uint32_t;
+        static constexpr handle npos = UINT32_MAX;
+
+    private:
+        static constexpr std::size_t segment_size = 64;
+        static constexpr unsigned segment_bits = 6;
+
+        // density bounds of a window, from one segment (leaf) to the whole array (root)
+        static constexpr double leaf_upper = 1.0;
+        static constexpr double root_upper = 0.5;
+        static constexpr double leaf_lower = 1.0 / 64;
+        static constexpr double root_lower = 0.125;
+
+        SmallVector<T, InlineCapacity, Growth> slots;
+        SmallVector<std::uint32_t, InlineCapacity, Growth> counts;   // elements per segment
+        SmallVector<std::uint32_t, InlineCapacity, Growth> fenwick;  // prefix sums of counts
+        std::size_t element_count = 0;
+        std::size_t reserved_slots = 0;  // memory kept for reserve()
+        unsigned height = 0;  // number of segments = 2^height
+        std::size_t modifications = 0;
+        Compare compare;
+
+        std::size_t segments() const {
+            return this->counts.size();
+        }
+
+        T* segmentBegin(std::size_t segment) {
+            return this->slots.data() + (segment << segment_bits);
+        }
+
+        const T* segmentBegin(std::size_t segment) const {
+            return this->slots.data() + (segment << segment_bits);
+        }
+
+        // the allowed density of a window of 2^level segments
+        double upperDensity(unsigned level) const {
+            double depth = this->height == 0 ? 1.0 : static_cast<double>(level) / this->height;
+            return leaf_upper - (leaf_upper - root_upper) * depth;
+        }
+
+        double lowerDensity(unsigned level) const {
+            double depth = this->height == 0 ? 1.0 : static_cast<double>(level) / this->height;
+            return leaf_lower + (root_lower - leaf_lower) * depth;
+        }
+
+        // adds delta to the count of segment, unsigned wrap-around takes care of negative deltas
+        void fenwickAdd(std::size_t segment, std::uint32_t delta) {
+            for (std::size_t position = segment + 1; position <= this->segments(); position += position & (~position + 1)) {
+                this->fenwick[position - 1] += delta;
+            }
+        }
+
+        void fenwickBuild() {
+            for (std::size_t segment = 0; segment < this->segments(); ++segment) {
+                this->fenwick[segment] = this->counts[segment];
+            }
+            for (std::size_t position = 1; position <= this->segments(); ++position) {
+                std::size_t parent = position + (position & (~position + 1));
+                if (parent <= this->segments()) {
+                    this->fenwick[parent - 1] += this->fenwick[position - 1];
+                }
+            }
+        }
+
+        // number of elements in the segments before segment
+        std::size_t prefix(std::size_t segment) const {
+            std::size_t sum = 0;
+            for (std::size_t position = segment; position > 0; position &= position - 1) {
+                sum += this->fenwick[position - 1];
+            }
+            return sum;
+        }
+
+        /* segmentFor
+           the last segment whose first element is not greater than value
+           (inclusive) or less than value (exclusive), segment 0 when there
+           is none. relies on every segment holding an element.
+           time complexity: O(log n).
+        */
+        std::size_t segmentFor(const T& value, bool inclusive) const {
+            std::size_t low = 0;
+            std::size_t high = this->segments();
+            while (high - low > 1) {
+                std::size_t middle = low + (high - low) / 2;
+                const T& first = *this->segmentBegin(middle);
+                bool before = inclusive ? !this->compare(value, first) : this->compare(first, value);
+                if (before) {
+                    low = middle;
+                } else {
+                    high = middle;
+                }
+            }
+            return low;
+        }
+
+        // spreads the sorted elements evenly over the segments [first, first + width)
+        void spread(std::size_t first, std::size_t width, std::span<const T> sorted) {
+            std::size_t share = sorted.size() / width;
+            std::size_t extra = sorted.size() % width;
+            const T* source = sorted.data();
+            for (std::size_t segment = first; segment < first + width; ++segment) {
+                std::size_t count = share + (segment - first < extra ? 1 : 0);
+                std::copy(source, source + count, this->segmentBegin(segment));
+                source += count;
+                this->fenwickAdd(segment, static_cast<std::uint32_t>(count) - this->counts[segment]);
+                this->counts[segment] = static_cast<std::uint32_t>(count);
+            }
+        }
+
+        std::pmr::vector<T> window(std::size_t first, std::size_t width) const {
+            std::pmr::vector<T> gathered(this->slots.memoryResource());
+            for (std::size_t segment = first; segment < first + width; ++segment) {
+                gathered.insert(gathered.end(), this->segmentBegin(segment), this->segmentBegin(segment) + this->counts[segment]);
+            }
+            return gathered;
+        }
+
+        // the smallest capacity that holds count elements within the root density
+        static std::size_t capacityFor(std::size_t count) {
+            std::size_t capacity = segment_size;
+            while (static_cast<double>(count) > root_upper * static_cast<double>(capacity)) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        /* build
+           replaces the whole array with the sorted values, spread evenly
+           over capacity slots. the old memory is given back first, unless
+           reserve() asked to keep room for at least capacity slots.
+           time complexity: O(n + capacity).
+        */
+        void build(std::span<const T> sorted, std::size_t capacity) {
+            std::size_t segmentCount = capacity >> segment_bits;
+            bool keep = capacity <= this->reserved_slots;
+            this->slots.clear();
+            this->counts.clear();
+            this->fenwick.clear();
+            if (!keep) {
+                this->slots.shrink_to_fit();
+                this->counts.shrink_to_fit();
+                this->fenwick.shrink_to_fit();
+            }
+            this->slots.assign(capacity, T());
+            this->counts.assign(segmentCount, 0);
+            this->fenwick.assign(segmentCount, 0);
+            this->height = static_cast<unsigned>(std::countr_zero(segmentCount));
+            this->element_count = sorted.size();
+            std::size_t share = sorted.size() / segmentCount;
+            std::size_t extra = sorted.size() % segmentCount;
+            const T* source = sorted.data();
+            for (std::size_t segment = 0; segment < segmentCount; ++segment) {
+                std::size_t count = share + (segment < extra ? 1 : 0);
+                std::copy(source, source + count, this->segmentBegin(segment));
+                source += count;
+                this->counts[segment] = static_cast<std::uint32_t>(count);
+            }
+            this->fenwickBuild();
+        }
+
+        void build(std::span<const T> sorted) {
+            this->build(sorted, capacityFor(sorted.size()));
+        }
+
+        std::pmr::vector<T> elements() const {
+            return this->window(0, this->segments());
+        }
+
+        // one more element goes into a full segment
+        void rebalanceInsert(std::size_t segment, const T& value) {
+            for (unsigned level = 1; level <= this->height; ++level) {
+                std::size_t width = std::size_t{1} << level;
+                std::size_t first = segment & ~(width - 1);
+                std::size_t count = this->prefix(first + width) - this->prefix(first) + 1;
+                if (static_cast<double>(count) <= this->upperDensity(level) * static_cast<double>(width * segment_size)) {
+                    std::pmr::vector<T> gathered = this->window(first, width);
+                    gathered.insert(std::upper_bound(gathered.begin(), gathered.end(), value, this->compare), value);
+                    this->spread(first, width, gathered);
+                    ++this->element_count;
+                    return;
+                }
+            }
+            std::pmr::vector<T> gathered = this->elements();
+            gathered.insert(std::upper_bound(gathered.begin(), gathered.end(), value, this->compare), value);
+            this->build(gathered, 2 * this->slots.size());
+        }
+
+        // segment lost its last element
+        void rebalanceErase(std::size_t segment) {
+            for (unsigned level = 1; level <= this->height; ++level) {
+                std::size_t width = std::size_t{1} << level;
+                std::size_t first = segment & ~(width - 1);
+                std::size_t count = this->prefix(first + width) - this->prefix(first);
+                if (static_cast<double>(count) >= this->lowerDensity(level) * static_cast<double>(width * segment_size)) {
+                    this->spread(first, width, this->window(first, width));
+                    return;
+                }
+            }
+            this->build(this->elements());
+        }
+
+    public:
+        explicit PackedMemoryArray(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : slots(resource), counts(resource), fenwick(resource) {}
+
+        PackedMemoryArray(const PackedMemoryArray&) = default;
+        PackedMemoryArray& operator=(const PackedMemoryArray&) = default;
+
+        // the moved-from array is left empty, like after clear(), and the
+        // reserved memory goes along with the slots
+        PackedMemoryArray(PackedMemoryArray&& other) noexcept
+            : slots(std::move(other.slots)), counts(std::move(other.counts)), fenwick(std::move(other.fenwick)), element_count(other.element_count),
+              reserved_slots(other.reserved_slots), height(other.height), modifications(other.modifications), compare(other.compare) {
+            other.reserved_slots = 0;
+            other.clear();
+        }
+
+        // the version moves past both old ones, so no cached handle survives
+        PackedMemoryArray& operator=(PackedMemoryArray&& other) {
+            if (this != &other) {
+                std::size_t version = std::max(this->modifications, other.modifications) + 1;
+                this->slots = std::move(other.slots);
+                this->counts = std::move(other.counts);
+                this->fenwick = std::move(other.fenwick);
+                this->element_count = other.element_count;
+                this->reserved_slots = other.reserved_slots;
+                this->height = other.height;
+                this->modifications = version;
+                this->compare = other.compare;
+                other.reserved_slots = 0;
+                other.clear();
+            }
+            return *this;
+        }
+
+        std::pmr::memory_resource* memoryResource() const {
+            return this->slots.memoryResource();
+        }
+
+        std::size_t size() const {
+            return this->element_count;
+        }
+
+        bool empty() const {
+            return this->element_count == 0;
+        }
+
+        std::size_t version() const {
+            return this->modifications;
+        }
+
+        // how many elements fit before the array has to reallocate
+        std::size_t capacity() const {
+            return static_cast<std::size_t>(root_upper * static_cast<double>(std::max(this->slots.size(), this->reserved_slots)));
+        }
+
+        /* reserve
+           allocates the arrays for capacity elements. the elements stay
+           where they are (every segment has to keep one), the array doubles
+           into the reserved memory when it fills up.
+           time complexity: O(n) when the memory grows, O(1) otherwise.
+        */
+        void reserve(std::size_t capacity) {
+            std::size_t slotCount = capacityFor(capacity);
+            if (slotCount > this->reserved_slots) {
+                this->reserved_slots = slotCount;
+                this->slots.reserve(slotCount);
+                this->counts.reserve(slotCount >> segment_bits);
+                this->fenwick.reserve(slotCount >> segment_bits);
+            }
+        }
+
+        // respreads the elements over the smallest array that holds them
+        // and gives back the reserved memory - O(n)
+        void shrink_to_fit() {
+            this->reserved_slots = 0;
+            if (capacityFor(this->element_count) < this->slots.size()) {
+                this->build(this->elements());
+                ++this->modifications;
+            } else {
+                this->slots.shrink_to_fit();
+                this->counts.shrink_to_fit();
+                this->fenwick.shrink_to_fit();
+            }
+        }
+
+        // an erase moves the elements right away, there are never tombstones
+        std::size_t tombstones() const {
+            return 0;
+        }
+
+        // kept for the interface of the tree, only checks the ratio
+        void setCompactionThreshold(double ratio) {
+            if (!(ratio >= 0.0 && ratio <= 1.0)) {
+                throw std::invalid_argument("compaction threshold must be between 0 and 1");
+            }
+        }
+
+        /* insert
+           places value after all the elements that are equal to it.
+           time complexity: O(log^2 n) amortized.
+        */
+        void insert(const T& value) {
+            if (this->slots.empty()) {
+                this->build(std::span<const T>(), segment_size);
+            }
+            std::size_t segment = this->element_count == 0 ? 0 : this->segmentFor(value, true);
+            std::uint32_t count = this->counts[segment];
+            if (count == segment_size) {
+                this->rebalanceInsert(segment, value);
+            } else {
+                T* first = this->segmentBegin(segment);
+                T* position = std::upper_bound(first, first + count, value, this->compare);
+                std::move_backward(position, first + count, first + count + 1);
+                *position = value;
+                ++this->counts[segment];
+                this->fenwickAdd(segment, 1);
+                ++this->element_count;
+            }
+            ++this->modifications;
+        }
+
+        /* insertSorted
+           inserts an ascending batch, the result is the same as inserting
+           the values one by one. a big batch is merged with the elements and
+           the array is rebuilt, O(n + k), a small one goes one by one.
+        */
+        void insertSorted(std::span<const T> sorted) {
+            std::size_t total = this->size() + sorted.size();
+            if (sorted.size() * static_cast<std::size_t>(std::bit_width(total)) < total) {
+                for (const T& value : sorted) {
+                    this->insert(value);
+                }
+                return;
+            }
+            std::pmr::vector<T> current = this->elements();
+            std::pmr::vector<T> merged(this->memoryResource());
+            merged.reserve(total);
+            std::merge(current.begin(), current.end(), sorted.begin(), sorted.end(), std::back_inserter(merged), this->compare);
+            this->build(merged);
+            ++this->modifications;
+        }
+
+        /* eraseSorted
+           removes one occurrence for every value of an ascending batch
+           (values that run out are skipped) and returns how many were
+           removed. a big batch is filtered out in one pass and the array is
+           rebuilt, O(n + k), a small one goes one by one.
+        */
+        std::size_t eraseSorted(std::span<const T> sorted) {
+            std::size_t before = this->size();
+            if (sorted.size() * static_cast<std::size_t>(std::bit_width(before)) < before) {
+                std::size_t removed = 0;
+                for (const T& value : sorted) {
+                    if (this->erase(value)) {
+                        ++removed;
+                    }
+                }
+                return removed;
+            }
+            std::pmr::vector<T> current = this->elements();
+            std::pmr::vector<T> kept(this->memoryResource());
+            kept.reserve(before);
+            std::set_difference(current.begin(), current.end(), sorted.begin(), sorted.end(), std::back_inserter(kept), this->compare);
+            if (kept.size() != before) {
+                this->build(kept);
+                ++this->modifications;
+            }
+            return before - kept.size();
+        }
+
+        /* extractIf
+           removes every element for which predicate returns true and
+           returns them in ascending order, one pass and one rebuild.
+           time complexity: O(n).
+        */
+        template <typename Predicate>
+        std::pmr::vector<T> extractIf(Predicate predicate) {
+            std::pmr::vector<T> kept(this->memoryResource());
+            std::pmr::vector<T> removed(this->memoryResource());
+            kept.reserve(this->size());
+            for (handle node = this->front(); node != npos; node = this->next(node)) {
+                const T& value = this->slots[node];
+                if (predicate(value)) {
+                    removed.push_back(value);
+                } else {
+                    kept.push_back(value);
+                }
+            }
+            if (!removed.empty()) {
+                this->build(kept);
+                ++this->modifications;
+            }
+            return removed;
+        }
+
+        /* erase
+           removes the first occurrence of value.
+           returns false (and leaves the array untouched) when value is missing.
+           time complexity: O(log^2 n) amortized.
+        */
+        bool erase(const T& value) {
+            handle target = this->select(this->lowerBound(value));
+            if (target == npos || this->compare(value, this->slots[target])) {
+                return false;
+            }
+            std::size_t segment = target >> segment_bits;
+            T* first = this->segmentBegin(segment);
+            std::move(this->slots.data() + target + 1, first + this->counts[segment], this->slots.data() + target);
+            --this->counts[segment];
+            this->fenwickAdd(segment, UINT32_MAX);
+            --this->element_count;
+            if (this->counts[segment] == 0 && this->height != 0) {
+                this->rebalanceErase(segment);
+            }
+            ++this->modifications;
+            return true;
+        }
+
+        void clear() {
+            this->slots.clear();
+            this->counts.clear();
+            this->fenwick.clear();
+            this->element_count = 0;
+            this->height = 0;
+            ++this->modifications;
+        }
+
+        /* select
+           the handle of the rank-th smallest element (0 based),
+           npos when rank is out of range.
+           time complexity: O(log n), a descent of the Fenwick tree.
+        */
+        handle select(std::size_t rank) const {
+            if (rank >= this->element_count) {
+                return npos;
+            }
+            std::size_t segment = 0;
+            for (std::size_t step = std::bit_floor(this->segments()); step != 0; step >>= 1U) {
+                if (segment + step <= this->segments() && this->fenwick[segment + step - 1] <= rank) {
+                    segment += step;
+                    rank -= this->fenwick[segment - 1];
+                }
+            }
+            return static_cast<handle>((segment << segment_bits) + rank);
+        }
+
+        // number of elements less than value - O(log n)
+        std::size_t lowerBound(const T& value) const {
+            if (this->element_count == 0) {
+                return 0;
+            }
+            std::size_t segment = this->segmentFor(value, false);
+            const T* first = this->segmentBegin(segment);
+            return this->prefix(segment) + static_cast<std::size_t>(std::lower_bound(first, first + this->counts[segment], value, this->compare) - first);
+        }
+
+        // number of elements not greater than value - O(log n)
+        std::size_t upperBound(const T& value) const {
+            if (this->element_count == 0) {
+                return 0;
+            }
+            std::size_t segment = this->segmentFor(value, true);
+            const T* first = this->segmentBegin(segment);
+            return this->prefix(segment) + static_cast<std::size_t>(std::upper_bound(first, first + this->counts[segment], value, this->compare) - first);
+        }
+
+        // walking the ascending order - O(1), every segment holds an element
+        handle front() const {
+            return this->element_count == 0 ? npos : 0;
+        }
+
+        handle back() const {
+            if (this->element_count == 0) {
+                return npos;
+            }
+            std::size_t segment = this->segments() - 1;
+            return static_cast<handle>((segment << segment_bits) + this->counts[segment] - 1);
+        }
+
+        handle next(handle node) const {
+            if (node == npos) {
+                return npos;
+            }
+            std::size_t segment = node >> segment_bits;
+            if ((node & (segment_size - 1)) + 1 < this->counts[segment]) {
+                return node + 1;
+            }
+            return segment + 1 < this->segments() ? static_cast<handle>((segment + 1) << segment_bits) : npos;
+        }
+
+        handle prev(handle node) const {
+            if (node == npos) {
+                return npos;
+            }
+            if ((node & (segment_size - 1)) != 0) {
+                return node - 1;
+            }
+            std::size_t segment = node >> segment_bits;
+            return segment == 0 ? npos : static_cast<handle>(((segment - 1) << segment_bits) + this->counts[segment - 1] - 1);
+        }
+
+        const T& value(handle node) const {
+            return this->slots[node];
+        }
+
+        /* gather
+           copies the elements from node on into out, as many as fit, and
+           returns the handle after the last one copied (npos at the end).
+           the elements of a segment are packed, so every segment is one
+           block copy.
+           time complexity: O(k) for k elements.
+        */
+        handle gather(handle node, std::span<T> out) const {
+            std::size_t copied = 0;
+            while (node != npos && copied < out.size()) {
+                std::size_t segment = node >> segment_bits;
+                std::size_t offset = node & (segment_size - 1);
+                std::size_t run = std::min<std::size_t>(this->counts[segment] - offset, out.size() - copied);
+                std::copy_n(this->slots.data() + node, run, out.data() + copied);
+                copied += run;
+                if (offset + run < this->counts[segment]) {
+                    node = static_cast<handle>(node + run);
+                } else {
+                    node = segment + 1 < this->segments() ? static_cast<handle>((segment + 1) << segment_bits) : npos;
+                }
+            }
+            return node;
+        }
+};
+
+}
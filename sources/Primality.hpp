@@ -0,0 +1,320 @@
+/*                        Primality.hpp
+   ======================================================================
+   This header file defines isPrime(), the primality test that decides
+   which elements the PrimeIterator visits.
+
+   Every integer width gets its own routine, chosen at compile time:
+   - 8 bit:  a 256 bit table built at compile time, one lookup.
+   - 16 bit: one lookup in the sieve table (below).
+   - 32 bit: the sieve table below its bound, otherwise division by the
+             primes below 256 as a prefilter and then a Miller-Rabin test
+             with the witnesses 2, 7 and 61, which has no false positive
+             below 4759123141. Products are taken in 64 bit arithmetic.
+   - 64 bit: the 32 bit routine when the value fits, otherwise the same
+             prefilter and a Miller-Rabin test with the 7 witnesses of
+             Jim Sinclair (2, 325, 9375, 28178, 450775, 9780504, 1795265022),
+             exact for every 64 bit value. Products are taken in 128 bit
+             arithmetic where the compiler has it, otherwise by doubling.
+   The Miller-Rabin tests are a few dozen multiplications per witness
+   where trial division up to the square root took tens of thousands of
+   divisions for values around 2^31.
+   Signed values are tested through their unsigned counterpart, after
+   the negatives (and 0 and 1) were rejected.
+
+   The sieve table is a sieve of Eratosthenes run at compile time over
+   the odd numbers below ARIEL_PRIME_TABLE_BOUND (2^20 unless it is
+   defined before the header is included, at least 65536 and a multiple
+   of 128): one bit per odd number, 64 KiB for 2^20, so a value below
+   the bound is one memory probe. The odd primes below 64 sieve whole
+   words with precomputed masks, the bigger ones cross off their
+   multiples one segment of 2^18 numbers at a time, which keeps every
+   loop under the constexpr loop limit of the compilers. It takes about
+   a second of compile time, a bigger bound takes longer and clang needs
+   -fconstexpr-steps above its default (the Makefile sets it).
+   PrimeSieve.hpp sieves the range of a batch at run time the same way.
+
+   PrimeTestable is the concept of the types that have a routine: the
+   integral types without bool.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ariel {
+
+template <typename T>
+concept PrimeTestable = std::integral<T> && !std::same_as<std::remove_cv_t<T>, bool> && sizeof(T) <= sizeof(std::uint64_t);
+
+namespace primality {
+
+    // bit i is set when i is a prime, sieve of Eratosthenes at compile time
+    inline constexpr std::array<std::uint64_t, 4> table8 = [] {
+        std::array<bool, 256> composite{};
+        std::array<std::uint64_t, 4> bits{};
+        for (std::size_t i = 2; i < 256; ++i) {
+            if (composite[i]) {
+                continue;
+            }
+            bits[i / 64] |= std::uint64_t{1} << (i % 64);
+            for (std::size_t multiple = i * i; multiple < 256; multiple += i) {
+                composite[multiple] = true;
+            }
+        }
+        return bits;
+    }();
+
+    constexpr bool isPrime8(std::uint8_t value) {
+        return ((table8[value / 64U] >> (value % 64U)) & 1U) != 0;
+    }
+
+    inline constexpr std::array<std::uint8_t, 54> primes_below_256 = [] {
+        std::array<std::uint8_t, 54> primes{};
+        std::size_t count = 0;
+        for (unsigned value = 2; value < 256; ++value) {
+            if (isPrime8(static_cast<std::uint8_t>(value))) {
+                primes[count++] = static_cast<std::uint8_t>(value);
+            }
+        }
+        return primes;
+    }();
+
+    template <typename U>
+    constexpr bool hasSmallFactor(U value) {
+        for (std::uint8_t prime : primes_below_256) {
+            if (value % prime == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+#ifndef ARIEL_PRIME_TABLE_BOUND
+#define ARIEL_PRIME_TABLE_BOUND (std::uint64_t{1} << 20U)
+#endif
+
+    inline constexpr std::uint64_t table_bound = ARIEL_PRIME_TABLE_BOUND;
+    static_assert(table_bound >= 65536 && table_bound % 128 == 0, "ARIEL_PRIME_TABLE_BOUND has to be at least 65536 and a multiple of 128");
+
+    // numbers per segment of the sieves, a segment of odd numbers fits the L1 cache
+    inline constexpr std::uint64_t segment_span = std::uint64_t{1} << 18U;
+
+    /* the sieves keep one bit per odd number, word w holding the odd 
+       numbers 128w + 1, ..., 128w + 127. an odd prime below 64 has a 
+       multiple in every word, and its multiples fall on the same bits in 
+       every word with the same w % prime: masks[i][w % prime] clears them 
+       for the i-th of small_odd_primes, so these primes sieve whole words 
+       at a time. */
+    inline constexpr std::array<std::uint8_t, 17> small_odd_primes = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+
+    struct WordMasks {
+        std::uint64_t masks[17][64];
+    };
+
+    constexpr WordMasks buildWordMasks() {
+        WordMasks result{};
+        for (std::size_t i = 0; i < small_odd_primes.size(); ++i) {
+            std::uint64_t prime = small_odd_primes[i];
+            for (std::uint64_t phase = 0; phase < prime; ++phase) {
+                for (std::uint64_t bit = 0; bit < 64; ++bit) {
+                    if ((128 * phase + 2 * bit + 1) % prime != 0) {
+                        result.masks[i][phase] |= std::uint64_t{1} << bit;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    inline constexpr WordMasks word_masks = buildWordMasks();
+
+    // bit j is set when 2j + 1 is a prime, the first word of a finished sieve
+    inline constexpr std::uint64_t odd_primes_below_128 = [] {
+        std::uint64_t word = 0;
+        for (unsigned bit = 0; bit < 64; ++bit) {
+            if (isPrime8(static_cast<std::uint8_t>(2 * bit + 1))) {
+                word |= std::uint64_t{1} << bit;
+            }
+        }
+        return word;
+    }();
+
+    /* bit i of the words is set when 2i + 1 is a prime, for every odd 
+       number below table_bound. a plain array: the compilers evaluate 
+       it several times faster at compile time than a std::array. */
+    struct SieveTable {
+        std::uint64_t words[table_bound / 128];
+    };
+
+    constexpr SieveTable buildTable() {
+        SieveTable sieve{};
+        constexpr std::uint64_t word_count = table_bound / 128;
+        for (std::uint64_t word = 0; word < word_count; ++word) {
+            sieve.words[word] = ~std::uint64_t{0};
+        }
+        for (std::size_t i = 0; i < small_odd_primes.size(); ++i) {
+            std::uint64_t prime = small_odd_primes[i];
+            for (std::uint64_t word = 0, phase = 0; word < word_count; ++word) {
+                sieve.words[word] &= word_masks.masks[i][phase];
+                phase = phase + 1 == prime ? 0 : phase + 1;
+            }
+        }
+        // the primes below 64 crossed themselves off, and 1 is not a prime
+        sieve.words[0] = odd_primes_below_128;
+        // the bigger primes cross off their odd multiples one by one, one
+        // segment at a time
+        for (std::uint64_t low = 0; low < table_bound; low += segment_span) {
+            std::uint64_t high = low + segment_span < table_bound ? low + segment_span : table_bound;
+            for (std::uint64_t prime = 67; prime * prime < high; prime += 2) {
+                if (((sieve.words[prime / 128] >> (prime / 2 % 64)) & 1U) == 0) {
+                    continue;
+                }
+                // the first odd multiple in the segment, not below prime^2
+                std::uint64_t multiple = prime * prime < low ? (low + prime - 1) / prime * prime : prime * prime;
+                if (multiple % 2 == 0) {
+                    multiple += prime;
+                }
+                for (; multiple < high; multiple += 2 * prime) {
+                    sieve.words[multiple / 128] &= ~(std::uint64_t{1} << (multiple / 2 % 64));
+                }
+            }
+        }
+        return sieve;
+    }
+
+    inline constexpr SieveTable table = buildTable();
+
+    // value < table_bound
+    constexpr bool lookup(std::uint64_t value) {
+        if (value % 2 == 0) {
+            return value == 2;
+        }
+        return ((table.words[value / 128] >> (value / 2 % 64)) & 1U) != 0;
+    }
+
+    constexpr bool isPrime16(std::uint16_t value) {
+        return lookup(value);
+    }
+
+    // (a * b) % modulus without overflowing 64 bits
+    constexpr std::uint64_t multiplyMod(std::uint64_t a, std::uint64_t b, std::uint64_t modulus) {
+#ifdef __SIZEOF_INT128__
+        __extension__ using Wide = unsigned __int128;
+        return static_cast<std::uint64_t>(Wide{a} * b % modulus);
+#else
+        std::uint64_t product = 0;
+        a %= modulus;
+        for (; b != 0; b >>= 1U) {
+            if ((b & 1U) != 0) {
+                product = product >= modulus - a ? product - (modulus - a) : product + a;
+            }
+            a = a >= modulus - a ? a - (modulus - a) : a + a;
+        }
+        return product;
+#endif
+    }
+
+    /* one Miller-Rabin round: false when witness proves the odd value > 2
+       composite. multiply(a, b) returns (a * b) % value. */
+    template <typename U, typename Multiply>
+    constexpr bool strongProbablePrime(U value, U witness, Multiply multiply) {
+        U base = witness % value;
+        if (base == 0) {
+            return true;
+        }
+        U odd = value - 1;
+        int squarings = std::countr_zero(odd);
+        odd >>= squarings;
+        U current = 1;
+        for (; odd != 0; odd >>= 1U) {
+            if ((odd & 1U) != 0) {
+                current = multiply(current, base);
+            }
+            base = multiply(base, base);
+        }
+        if (current == 1 || current == value - 1) {
+            return true;
+        }
+        for (int i = 1; i < squarings; ++i) {
+            current = multiply(current, current);
+            if (current == value - 1) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline constexpr std::array<std::uint32_t, 3> witnesses32 = {2, 7, 61};
+    inline constexpr std::array<std::uint64_t, 7> witnesses64 = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+    constexpr bool isPrime32(std::uint32_t value) {
+        if (value < table_bound) {
+            return lookup(value);
+        }
+        if (hasSmallFactor(value)) {
+            return false;
+        }
+        auto multiply = [value](std::uint32_t a, std::uint32_t b) {
+            return static_cast<std::uint32_t>(std::uint64_t{a} * b % value);
+        };
+        for (std::uint32_t witness : witnesses32) {
+            if (!strongProbablePrime(value, witness, multiply)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool isPrime64(std::uint64_t value) {
+        if (value < table_bound) {
+            return lookup(value);
+        }
+        if (value <= UINT32_MAX) {
+            return isPrime32(static_cast<std::uint32_t>(value));
+        }
+        if (hasSmallFactor(value)) {
+            return false;
+        }
+        auto multiply = [value](std::uint64_t a, std::uint64_t b) {
+            return multiplyMod(a, b, value);
+        };
+        for (std::uint64_t witness : witnesses64) {
+            if (!strongProbablePrime(value, witness, multiply)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+/*                            isPrime
+   ======================================================================
+   true when value is a prime number, dispatching on the width of T.
+   */
+template <PrimeTestable T>
+constexpr bool isPrime(T value) {
+    if constexpr (std::is_signed_v<T>) {
+        if (value < 2) {
+            return false;
+        }
+    }
+    using Unsigned = std::make_unsigned_t<T>;
+    auto magnitude = static_cast<Unsigned>(value);
+    if constexpr (sizeof(T) == sizeof(std::uint8_t)) {
+        return primality::isPrime8(magnitude);
+    } else if constexpr (sizeof(T) == sizeof(std::uint16_t)) {
+        return primality::isPrime16(magnitude);
+    } else if constexpr (sizeof(T) == sizeof(std::uint32_t)) {
+        return primality::isPrime32(magnitude);
+    } else {
+        return primality::isPrime64(magnitude);
+    }
+}
+
+}
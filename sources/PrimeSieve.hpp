@@ -0,0 +1,166 @@
+/*                        PrimeSieve.hpp
+   ======================================================================
+   This header file defines PrimeSieve, a segmented sieve of Eratosthenes
+   over the value range [lo, hi] of a batch, which the MagicalContainer
+   uses to classify a big batch of elements at once instead of testing
+   them one by one with isPrime().
+
+   The sieve keeps one bit per odd number of the range, laid out like the
+   compile time table of Primality.hpp (word w holds 128w + 1, ...,
+   128w + 127), so:
+   - the odd primes below 64 sieve whole words with the precomputed
+     masks of primality::word_masks,
+   - the bigger primes up to sqrt(hi) come out of the compile time table
+     and cross off their odd multiples one segment of
+     primality::segment_span numbers at a time, so the part of the bitmap
+     that is being written stays in the L1 cache.
+   Building it costs about one cheap operation per number of the range,
+   while isPrime() costs a Miller-Rabin test per element above the table
+   bound. suits() decides between the two from the size of the batch and
+   the width of its range (see the primes section of Bench.cpp).
+   The base primes have to be in the table, so the sieve works for
+   ranges below table_bound^2 (2^40 for the default bound).
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+#include "Primality.hpp"
+
+namespace ariel {
+
+template <PrimeTestable T>
+class PrimeSieve {
+    private:
+        using Unsigned = std::make_unsigned_t<T>;
+
+        // the first word holds 128 * first_word + 1, ...
+        std::uint64_t first_word = 0;
+        T lo;
+        T hi;
+        std::pmr::vector<std::uint64_t> words;
+
+        // value as a non negative number (value >= 0)
+        static std::uint64_t magnitude(T value) {
+            return static_cast<std::uint64_t>(static_cast<Unsigned>(value));
+        }
+
+        // every base prime crosses off its odd multiples below high
+        void crossOff(std::uint64_t high, const std::pmr::vector<std::uint64_t>& primes, std::pmr::vector<std::uint64_t>& multiples) {
+            std::uint64_t origin = 128 * this->first_word;
+            for (std::size_t i = 0; i < primes.size(); ++i) {
+                std::uint64_t prime = primes[i];
+                std::uint64_t multiple = multiples[i];
+                for (; multiple < high; multiple += 2 * prime) {
+                    std::uint64_t offset = multiple - origin;
+                    this->words[offset / 128] &= ~(std::uint64_t{1} << (offset / 2 % 64));
+                }
+                multiples[i] = multiple;
+            }
+        }
+
+    public:
+        // sieving pays off when the range has at most max_gap numbers per element
+        static constexpr std::uint64_t max_gap = 32;
+        // and the batch is big enough to pay for collecting the base primes
+        static constexpr std::size_t min_batch = 1024;
+
+        /* suits
+           true when sieving [lo, hi] classifies count elements faster than
+           count calls of isPrime().
+        */
+        static bool suits(std::size_t count, T lo, T hi) {
+            if (count < min_batch || hi < T(2) || magnitude(hi) < primality::table_bound) {
+                return false;
+            }
+            std::uint64_t low = lo < T(2) ? 2 : magnitude(lo);
+            std::uint64_t high = magnitude(hi);
+            if (high / primality::table_bound >= primality::table_bound) {
+                return false;
+            }
+            return (high - low) / max_gap <= count;
+        }
+
+        /* the constructor
+           sieves the odd numbers of [first, last], with first <= last and
+           last < table_bound^2.
+           time complexity: O((last - first) log log last + sqrt(last)).
+        */
+        PrimeSieve(T first, T last, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : lo(first), hi(last), words(resource) {
+            if (this->hi < T(2)) {
+                return;
+            }
+            std::uint64_t low = this->lo < T(2) ? 0 : magnitude(this->lo);
+            std::uint64_t high = magnitude(this->hi) + 1;
+            this->first_word = low / 128;
+            std::uint64_t word_count = (high + 127) / 128 - this->first_word;
+            this->words.assign(word_count, ~std::uint64_t{0});
+
+            for (std::size_t i = 0; i < primality::small_odd_primes.size(); ++i) {
+                std::uint64_t prime = primality::small_odd_primes[i];
+                std::uint64_t phase = this->first_word % prime;
+                for (std::uint64_t& word : this->words) {
+                    word &= primality::word_masks.masks[i][phase];
+                    phase = phase + 1 == prime ? 0 : phase + 1;
+                }
+            }
+            if (this->first_word == 0) {
+                this->words[0] = primality::odd_primes_below_128;
+            }
+
+            // the base primes from 67 to sqrt(high), with their next odd
+            // multiple (not below prime^2) in the range
+            std::pmr::vector<std::uint64_t> primes(resource);
+            std::pmr::vector<std::uint64_t> multiples(resource);
+            std::uint64_t origin = 128 * this->first_word;
+            for (std::uint64_t word = 0; 128 * word * 128 * word < high; ++word) {
+                // word 0 holds the primes below 64, the masks took care of them
+                std::uint64_t bits = primality::table.words[word] & (word == 0 ? ~std::uint64_t{0} << 33U : ~std::uint64_t{0});
+                for (; bits != 0; bits &= bits - 1) {
+                    std::uint64_t prime = 128 * word + 2 * static_cast<std::uint64_t>(std::countr_zero(bits)) + 1;
+                    if (prime * prime >= high) {
+                        break;
+                    }
+                    std::uint64_t multiple = std::max(prime * prime, (origin + prime - 1) / prime * prime);
+                    if (multiple % 2 == 0) {
+                        multiple += prime;
+                    }
+                    primes.push_back(prime);
+                    multiples.push_back(multiple);
+                }
+            }
+            for (std::uint64_t segment = origin; segment < high; segment += primality::segment_span) {
+                this->crossOff(std::min(segment + primality::segment_span, high), primes, multiples);
+            }
+        }
+
+        /* contains
+           true when value is a prime, the same as isPrime(value). a value
+           outside [lo, hi] is handed to isPrime().
+           time complexity: O(1) inside the range.
+        */
+        bool contains(T value) const {
+            if (value < this->lo || this->hi < value) {
+                return isPrime(value);
+            }
+            if (value < T(2)) {
+                return false;
+            }
+            std::uint64_t number = magnitude(value);
+            if (number % 2 == 0) {
+                return number == 2;
+            }
+            std::uint64_t offset = number - 128 * this->first_word;
+            return ((this->words[offset / 128] >> (offset / 2 % 64)) & 1U) != 0;
+        }
+};
+
+}
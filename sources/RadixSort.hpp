@@ -0,0 +1,123 @@
+/*                        RadixSort.hpp
+   ======================================================================
+   This header file defines radixSort(), the sort the MagicalContainer
+   uses for big batches of 32 bit elements instead of std::sort.
+
+   It is a least significant digit radix sort with 8 bit digits: four
+   stable passes, each one scattering the elements into 256 buckets by
+   one byte of the key, from the lowest byte to the highest. That is
+   O(n) work instead of O(n log n) comparisons, which wins from about 64
+   elements on (see the sort section of Bench.cpp).
+   - The key of a signed element has its sign bit flipped, which maps
+     INT32_MIN..INT32_MAX onto 0..UINT32_MAX in the same order, so the
+     negative elements come out before the positive ones.
+   - One pass over the elements counts all four digit histograms. The
+     counting is bound by the increments of the histograms and not by
+     splitting the keys, so it stays a scalar loop (splitting them 8 at a
+     time with AVX2 made it about a third slower).
+   - A digit that is the same for every element (the high bytes of small
+     numbers, for example) skips its pass.
+   The passes move the elements between the input and a scratch buffer
+   of the same size, taken from the given memory resource.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ariel {
+
+template <typename T>
+concept RadixSortable = std::integral<T> && sizeof(T) == sizeof(std::uint32_t);
+
+namespace radix {
+
+    // below this many elements std::sort is faster: Bench.cpp measures a
+    // tie at 32 elements and a radix sort twice as fast at 64
+    inline constexpr std::size_t threshold = 64;
+
+    using Histograms = std::array<std::array<std::uint32_t, 256>, 4>;
+
+    template <RadixSortable T>
+    constexpr std::uint32_t flip() {
+        return std::is_signed_v<T> ? 0x80000000U : 0U;
+    }
+
+    template <RadixSortable T>
+    constexpr std::uint32_t key(T value) {
+        return std::bit_cast<std::uint32_t>(value) ^ flip<T>();
+    }
+
+    // the four digit histograms of the keys, in one pass
+    inline void count(const std::uint32_t* keys, std::size_t size, std::uint32_t flipped, Histograms& histograms) {
+        for (std::size_t i = 0; i < size; ++i) {
+            std::uint32_t current = keys[i] ^ flipped;
+            ++histograms[0][current & 0xFFU];
+            ++histograms[1][(current >> 8U) & 0xFFU];
+            ++histograms[2][(current >> 16U) & 0xFFU];
+            ++histograms[3][current >> 24U];
+        }
+    }
+}
+
+/*                           radixSort
+   ======================================================================
+   sorts values in ascending order (the order of std::less<T>).
+   scratch has to hold values.size() elements, its contents are lost.
+   time complexity: O(n), at most 5 passes over the elements.
+   */
+template <RadixSortable T>
+void radixSort(std::span<T> values, std::span<T> scratch) {
+    if (values.size() < 2) {
+        return;
+    }
+    radix::Histograms histograms{};
+    radix::count(reinterpret_cast<const std::uint32_t*>(values.data()), values.size(), radix::flip<T>(), histograms);
+
+    T* source = values.data();
+    T* target = scratch.data();
+    for (unsigned digit = 0; digit < 4; ++digit) {
+        std::array<std::uint32_t, 256>& histogram = histograms[digit];
+        std::uint32_t firstDigit = (radix::key(source[0]) >> (8U * digit)) & 0xFFU;
+        if (histogram[firstDigit] == values.size()) {
+            continue;
+        }
+        // the counts become the starting position of every bucket
+        std::uint32_t position = 0;
+        for (std::uint32_t& bucket : histogram) {
+            std::uint32_t size = bucket;
+            bucket = position;
+            position += size;
+        }
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            target[histogram[(radix::key(source[i]) >> (8U * digit)) & 0xFFU]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+    if (source != values.data()) {
+        std::copy(source, source + values.size(), values.data());
+    }
+}
+
+// sorts values with a scratch buffer from resource
+template <RadixSortable T>
+void radixSort(std::span<T> values, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    if (values.size() < 2) {
+        return;
+    }
+    std::pmr::vector<T> scratch(values.size(), resource);
+    radixSort(values, std::span<T>(scratch));
+}
+
+}
@@ -0,0 +1,242 @@
+/*                        SmallVector.hpp
+   ======================================================================
+   This header file defines the SmallVector class, a dynamic array that
+   keeps its first N elements inside the object itself.
+
+   As long as the array holds at most N elements it does not allocate
+   anything, the elements live in an inline buffer. When it outgrows the
+   buffer, the elements move to the heap and from then on it behaves
+   like a std::vector. How much it grows when it is full is decided by
+   the Growth policy (doubling by default, see GrowthPolicy.hpp).
+   shrink_to_fit() moves the elements back into the inline buffer when
+   they fit there again.
+
+   The heap part comes from a std::pmr::memory_resource (the default
+   resource unless another one is given), like a std::pmr::vector:
+   - the copy constructor uses the default resource, or the one it is
+     given explicitly,
+   - the move constructor takes the resource along with the elements,
+   - assignments keep the resource of the target.
+
+   The MagicalContainer uses it for all of its internal arrays, so a
+   container with a handful of elements costs no heap allocations at all,
+   and a bigger one allocates only from the resource it was given.
+   ======================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include "GrowthPolicy.hpp"
+
+namespace ariel {
+
+template <typename T, std::size_t N, typename Growth = DoublingGrowth>
+class SmallVector {
+    private:
+        alignas(T) std::byte inline_buffer[(N == 0 ? 1 : N) * sizeof(T)];
+        T* items;
+        std::size_t count = 0;
+        std::size_t allocated = N;
+        std::pmr::memory_resource* resource;
+
+        T* inlineItems() {
+            return std::launder(reinterpret_cast<T*>(this->inline_buffer));
+        }
+
+        bool isInline() const {
+            return this->items == reinterpret_cast<const T*>(this->inline_buffer);
+        }
+
+        // moves the elements to a buffer of exactly capacity elements
+        void reallocate(std::size_t capacity) {
+            T* fresh = capacity <= N ? this->inlineItems() : static_cast<T*>(this->resource->allocate(capacity * sizeof(T), alignof(T)));
+            if (fresh == this->items) {
+                return;
+            }
+            std::uninitialized_move(this->items, this->items + this->count, fresh);
+            std::destroy(this->items, this->items + this->count);
+            this->release();
+            this->items = fresh;
+            this->allocated = std::max(capacity, N);
+        }
+
+        void release() {
+            if (!this->isInline()) {
+                this->resource->deallocate(this->items, this->allocated * sizeof(T), alignof(T));
+            }
+        }
+
+        // takes the elements of other, which uses the same resource
+        void steal(SmallVector& other) {
+            if (other.isInline()) {
+                std::uninitialized_move(other.items, other.items + other.count, this->items);
+                this->count = other.count;
+                other.clear();
+            } else {
+                this->items = std::exchange(other.items, other.inlineItems());
+                this->count = std::exchange(other.count, 0);
+                this->allocated = std::exchange(other.allocated, N);
+            }
+        }
+
+        void copyFrom(const T* first, std::size_t size) {
+            this->clear();
+            this->reserve(size);
+            std::uninitialized_copy(first, first + size, this->items);
+            this->count = size;
+        }
+
+        void grow() {
+            this->reallocate(Growth::grow(this->allocated));
+        }
+
+    public:
+        explicit SmallVector(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : items(inlineItems()), resource(memory) {}
+
+        SmallVector(const SmallVector& other, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : items(inlineItems()), resource(memory) {
+            this->copyFrom(other.items, other.count);
+        }
+
+        SmallVector(SmallVector&& other) noexcept : items(inlineItems()), resource(other.resource) {
+            this->steal(other);
+        }
+
+        SmallVector& operator=(const SmallVector& other) {
+            if (this != &other) {
+                this->copyFrom(other.items, other.count);
+            }
+            return *this;
+        }
+
+        // the elements can only be taken over when both use the same resource
+        SmallVector& operator=(SmallVector&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            if (*this->resource != *other.resource) {
+                this->clear();
+                this->reserve(other.count);
+                std::uninitialized_move(other.items, other.items + other.count, this->items);
+                this->count = other.count;
+                other.clear();
+                return *this;
+            }
+            this->clear();
+            this->release();
+            this->items = this->inlineItems();
+            this->allocated = N;
+            this->steal(other);
+            return *this;
+        }
+
+        ~SmallVector() {
+            this->clear();
+            this->release();
+        }
+
+        std::size_t size() const {
+            return this->count;
+        }
+
+        std::pmr::memory_resource* memoryResource() const {
+            return this->resource;
+        }
+
+        std::size_t capacity() const {
+            return this->allocated;
+        }
+
+        bool empty() const {
+            return this->count == 0;
+        }
+
+        T* data() {
+            return this->items;
+        }
+
+        const T* data() const {
+            return this->items;
+        }
+
+        T* begin() {
+            return this->items;
+        }
+
+        T* end() {
+            return this->items + this->count;
+        }
+
+        const T* begin() const {
+            return this->items;
+        }
+
+        const T* end() const {
+            return this->items + this->count;
+        }
+
+        T& operator[](std::size_t position) {
+            return this->items[position];
+        }
+
+        const T& operator[](std::size_t position) const {
+            return this->items[position];
+        }
+
+        T& back() {
+            return this->items[this->count - 1];
+        }
+
+        const T& back() const {
+            return this->items[this->count - 1];
+        }
+
+        void reserve(std::size_t capacity) {
+            if (capacity > this->allocated) {
+                this->reallocate(capacity);
+            }
+        }
+
+        // gives back the unused heap memory
+        void shrink_to_fit() {
+            if (!this->isInline() && this->count < this->allocated) {
+                this->reallocate(this->count);
+            }
+        }
+
+        void push_back(const T& item) {
+            if (this->count == this->allocated) {
+                // item may live in this array, copy it before moving the elements
+                T copy(item);
+                this->grow();
+                ::new (static_cast<void*>(this->items + this->count)) T(std::move(copy));
+            } else {
+                ::new (static_cast<void*>(this->items + this->count)) T(item);
+            }
+            ++this->count;
+        }
+
+        void pop_back() {
+            std::destroy_at(this->items + --this->count);
+        }
+
+        // replaces the contents with size copies of item
+        void assign(std::size_t size, const T& item) {
+            this->clear();
+            this->reserve(size);
+            std::uninitialized_fill_n(this->items, size, item);
+            this->count = size;
+        }
+
+        void clear() {
+            std::destroy(this->items, this->items + this->count);
+            this->count = 0;
+        }
+};
+
+}